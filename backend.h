@@ -0,0 +1,70 @@
+#ifndef BACKEND_H
+#define BACKEND_H
+
+// Shared by the two LLVM lowerings: TAC text (llvm.cpp) and the type-checked AST (codegen.cpp).
+// Both produce a LoweredProgram; everything after that (verification, optimization, IR
+// output, object emission and JIT execution) lives in llvm.cpp and is backend independent.
+
+#include "compiler.h"
+
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/IRBuilder.h>
+
+#include <chrono>
+
+// A finished module together with the context that owns it. The context is heap-allocated
+// so the JIT can take both over as an ORC ThreadSafeModule.
+struct LoweredProgram {
+    unique_ptr<llvm::LLVMContext> context;
+    unique_ptr<llvm::Module> module;
+    bool mainReturnsVoid = false;
+};
+
+// Buffered output runtime (runtime.cpp), bound into every JIT. Native executables get the
+// same runtime emitted into the module as IR (NativeRuntimeBuilder in llvm.cpp).
+extern "C" {
+void __rt_print_int(int32_t value);
+void __rt_print_float(double value);
+void __rt_print_str(const char* text);
+void __rt_print_char(int32_t value);
+void __rt_flush();
+}
+
+// Source escape sequences (\n, \t, ...) of a string literal
+string processEscapes(const string& str);
+
+// One argument of a print statement: literal text, or a value printed according to its LLVM type
+struct PrintPiece {
+    string text;
+    llvm::Value* value = nullptr;
+};
+
+// Print lowering shared by both backends (llvm.cpp). A print statement becomes calls into the
+// runtime; adjacent literal text and integer constants are merged into one interned string.
+class PrintLowering {
+private:
+    llvm::Module& module;
+    map<string, llvm::Constant*> strings;
+    llvm::FunctionCallee printInt, printFloat, printStr, printChar;
+    
+    void emitText(llvm::IRBuilder<>& builder, const string& text);
+    
+public:
+    explicit PrintLowering(llvm::Module& module);
+    // Module-wide constant for `str`; the same text always yields the same global
+    llvm::Constant* stringConstant(llvm::IRBuilder<>& builder, const string& str);
+    void emit(llvm::IRBuilder<>& builder, const vector<PrintPiece>& pieces);
+};
+
+// AST lowering (codegen.cpp); throws CompilationError
+LoweredProgram lowerAST(const vector<ASTPtr>& ast);
+
+// Back half (llvm.cpp). Each consumes or inspects a lowered program and throws
+// CompilationError on failure.
+RunStats executeLoweredProgram(LoweredProgram program, const string& cacheKey,
+                               chrono::steady_clock::time_point buildStart);
+size_t writeLoweredIR(LoweredProgram& program, const string& irFile);
+void emitLoweredNative(LoweredProgram& program, const string& outputFile, bool link);
+
+#endif
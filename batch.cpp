@@ -0,0 +1,278 @@
+#include "compiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+// === Work-Stealing Pool ===
+// Every worker owns a deque: it pops its own work from the back and, once that runs dry,
+// steals from the front of the other workers' deques. Programs in a corpus vary wildly in
+// size, so a static split would leave most workers idle behind the one with the big files.
+class WorkStealingPool {
+private:
+    struct WorkerQueue {
+        deque<function<void()>> tasks;
+        mutex lock;
+    };
+
+    vector<unique_ptr<WorkerQueue>> queues;
+    size_t nextQueue;
+
+    bool popLocal(size_t id, function<void()>& task) {
+        WorkerQueue& q = *queues[id];
+        lock_guard<mutex> guard(q.lock);
+        if (q.tasks.empty()) return false;
+        task = move(q.tasks.back());
+        q.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(size_t thief, function<void()>& task) {
+        for (size_t i = 1; i < queues.size(); i++) {
+            WorkerQueue& victim = *queues[(thief + i) % queues.size()];
+            lock_guard<mutex> guard(victim.lock);
+            if (!victim.tasks.empty()) {
+                task = move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // All work is queued before run() and tasks never submit more, so once neither the
+    // worker's own deque nor any victim has a task left there is nothing to wait for
+    void workerLoop(size_t id) {
+        function<void()> task;
+        while (popLocal(id, task) || steal(id, task)) {
+            task();
+        }
+    }
+
+public:
+    WorkStealingPool(unsigned workers) : nextQueue(0) {
+        for (unsigned i = 0; i < max(1u, workers); i++) {
+            queues.push_back(make_unique<WorkerQueue>());
+        }
+    }
+
+    // Tasks are dealt round-robin before run(); stealing rebalances from there
+    void submit(function<void()> task) {
+        queues[nextQueue]->tasks.push_back(move(task));
+        nextQueue = (nextQueue + 1) % queues.size();
+    }
+
+    void run() {
+        vector<thread> threads;
+        for (size_t i = 1; i < queues.size(); i++) {
+            threads.emplace_back(&WorkStealingPool::workerLoop, this, i);
+        }
+        workerLoop(0);
+        for (auto& t : threads) t.join();
+    }
+};
+
+// === Input Expansion ===
+
+// Shell-style match supporting '*' and '?', used for quoted patterns like "tester/*.txt"
+static bool wildcardMatch(const string& pattern, const string& name) {
+    size_t p = 0, n = 0, starP = string::npos, starN = 0;
+    while (n < name.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+            p++; n++;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            starP = p++;
+            starN = n;
+        } else if (starP != string::npos) {
+            p = starP + 1;
+            n = ++starN;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') p++;
+    return p == pattern.size();
+}
+
+// The single-file driver dumps tokens.txt and tac.txt next to the sources; never treat those as programs
+static bool isCompilerDump(const fs::path& path) {
+    string name = path.filename().string();
+    return name == "tokens.txt" || name == "tac.txt";
+}
+
+static void expandInput(const string& input, vector<string>& files) {
+    if (!input.empty() && input[0] == '@') {
+        ifstream list(input.substr(1));
+        if (!list.is_open()) {
+            cerr << "Failed to open batch list: " << input.substr(1) << endl;
+            return;
+        }
+        string line;
+        while (getline(list, line)) {
+            line.erase(0, line.find_first_not_of(" \t\r"));
+            line.erase(line.find_last_not_of(" \t\r") + 1);
+            if (!line.empty() && line[0] != '#') expandInput(line, files);
+        }
+        return;
+    }
+
+    error_code ec;
+    if (fs::is_directory(input, ec)) {
+        vector<string> found;
+        for (const auto& entry : fs::directory_iterator(input, ec)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".txt" && !isCompilerDump(entry.path())) {
+                found.push_back(entry.path().string());
+            }
+        }
+        sort(found.begin(), found.end());
+        files.insert(files.end(), found.begin(), found.end());
+        return;
+    }
+
+    if (input.find_first_of("*?") != string::npos) {
+        fs::path pattern(input);
+        fs::path dir = pattern.has_parent_path() ? pattern.parent_path() : fs::path(".");
+        string namePattern = pattern.filename().string();
+        vector<string> found;
+        for (const auto& entry : fs::directory_iterator(dir, ec)) {
+            if (entry.is_regular_file() && !isCompilerDump(entry.path()) &&
+                wildcardMatch(namePattern, entry.path().filename().string())) {
+                found.push_back(entry.path().string());
+            }
+        }
+        sort(found.begin(), found.end());
+        files.insert(files.end(), found.begin(), found.end());
+        return;
+    }
+
+    files.push_back(input);
+}
+
+// === Batch Driver ===
+
+struct BatchResult {
+    string input;
+    bool success = false;
+    string failedPhase;
+    string message;
+    size_t tokenCount = 0;
+    long long durationMs = 0;
+};
+
+// Outputs are written as <base>.tokens.txt, <base>.tac.txt and <base>.ll; the AST backend
+// only writes the TAC file with --dump-tac
+static void compileOne(const string& input, const string& base, BatchResult& result) {
+    auto start = chrono::high_resolution_clock::now();
+
+    result.input = input;
+    string phase = "lex";
+    try {
+        vector<Token> tokens = lexAndDumpToFile(input, base + ".tokens.txt");
+        result.tokenCount = tokens.size();
+
+        phase = "parse";
+        auto ast = parseFromFile(tokens);
+
+        phase = "scope";
+        performScopeAnalysis(ast, tokens);
+
+        phase = "type";
+        performTypeChecking(ast, tokens);
+
+        if (compilerOptions.backend == Backend::TAC || compilerOptions.dumpTAC) {
+            phase = "tac";
+            generateTAC(ast, base + ".tac.txt");
+        }
+
+        phase = "codegen";
+        if (compilerOptions.backend == Backend::AST) {
+            compileASTToIR(ast, base + ".ll");
+        } else {
+            compileTACToIR(base + ".tac.txt", base + ".ll");
+        }
+
+        result.success = true;
+    } catch (const exception& e) {
+        result.failedPhase = phase;
+        result.message = e.what();
+    }
+
+    auto end = chrono::high_resolution_clock::now();
+    result.durationMs = chrono::duration_cast<chrono::milliseconds>(end - start).count();
+}
+
+int runBatchCompilation(const vector<string>& inputs, const string& outputDir, unsigned jobs) {
+    vector<string> files;
+    for (const auto& input : inputs) {
+        expandInput(input, files);
+    }
+    if (files.empty()) {
+        cerr << "Batch mode: no input files\n";
+        return EXIT_FAILURE;
+    }
+
+    error_code ec;
+    fs::create_directories(outputDir, ec);
+    if (ec) {
+        cerr << "Batch mode: cannot create output directory " << outputDir << ": " << ec.message() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    if (jobs == 0) jobs = max(1u, thread::hardware_concurrency());
+    jobs = min<unsigned>(jobs, files.size());
+
+    bool wasQuiet = compilerOptions.quiet;
+    compilerOptions.quiet = true;
+
+    auto start = chrono::high_resolution_clock::now();
+
+    // Inputs from different directories may share a file name; keep their outputs apart
+    vector<string> bases;
+    unordered_map<string, int> stemUses;
+    for (const auto& file : files) {
+        string stem = fs::path(file).stem().string();
+        int uses = stemUses[stem]++;
+        if (uses > 0) stem += "_" + to_string(uses);
+        bases.push_back((fs::path(outputDir) / stem).string());
+    }
+
+    vector<BatchResult> results(files.size());
+    WorkStealingPool pool(jobs);
+    for (size_t i = 0; i < files.size(); i++) {
+        pool.submit([&, i]() { compileOne(files[i], bases[i], results[i]); });
+    }
+    pool.run();
+
+    auto end = chrono::high_resolution_clock::now();
+    long long totalMs = chrono::duration_cast<chrono::milliseconds>(end - start).count();
+
+    compilerOptions.quiet = wasQuiet;
+
+    // Summary: one line per input in submission order, then totals
+    ostringstream summary;
+    size_t failures = 0;
+    for (const auto& r : results) {
+        if (r.success) {
+            summary << "[OK]     " << r.input << " (" << r.tokenCount << " tokens, " << r.durationMs << " ms)\n";
+        } else {
+            failures++;
+            summary << "[FAILED] " << r.input << " in " << r.failedPhase << ": " << r.message << "\n";
+        }
+    }
+    summary << "\n" << files.size() << " file(s), " << (files.size() - failures) << " succeeded, "
+            << failures << " failed, " << jobs << " worker(s), " << totalMs << " ms\n";
+
+    cout << "\n=== Batch Compilation Summary ===\n" << summary.str();
+
+    ofstream summaryFile((fs::path(outputDir) / "summary.txt").string());
+    if (summaryFile.is_open()) {
+        summaryFile << summary.str();
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
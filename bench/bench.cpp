@@ -0,0 +1,320 @@
+#include "../compiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+
+namespace fs = std::filesystem;
+
+// === Synthetic Program Generators ===
+// Every generator is deterministic, so the same size always produces the same source and
+// numbers from two runs (or two commits) are directly comparable.
+
+// N small leaf functions, each called once from main
+static string generateFunctions(int n) {
+    ostringstream src;
+    src << "include<main>\n\n";
+    for (int i = 0; i < n; i++) {
+        src << "int helper" << i << "(int a, int b) {\n"
+            << "    int r = a * " << (i % 13 + 1) << " + b;\n"
+            << "    if (r > 1000) {\n"
+            << "        r = r - 1000;\n"
+            << "    }\n"
+            << "    return r;\n"
+            << "}\n\n";
+    }
+    src << "main {\n    int acc = 0;\n";
+    for (int i = 0; i < n; i++) {
+        src << "    acc = helper" << i << "(" << i << ", acc);\n";
+    }
+    src << "    print(acc);\n}\n";
+    return src.str();
+}
+
+// A few statements whose right-hand side is a left-nested expression `depth` operators deep
+static string generateDeepExpressions(int depth) {
+    static const char* ops[] = {"+", "-", "*", "&", "|", "^"};
+    ostringstream src;
+    src << "include<main>\n\nmain {\n    int x = 3;\n    int y = 5;\n";
+    for (int s = 0; s < 4; s++) {
+        string expr = (s % 2 == 0) ? "x" : "y";
+        for (int d = 0; d < depth; d++) {
+            expr = "(" + expr + " " + ops[(d + s) % 6] + " " + to_string(d % 7 + 1) + ")";
+        }
+        src << "    int e" << s << " = " << expr << ";\n";
+    }
+    src << "    print(e0, e1, e2, e3);\n}\n";
+    return src.str();
+}
+
+// One dispatch function with a `cases`-long switch, called from a loop
+static string generateSwitchChain(int cases) {
+    ostringstream src;
+    src << "include<main>\n\nint dispatch(int op) {\n    int r = 0;\n    switch (op) {\n";
+    for (int c = 0; c < cases; c++) {
+        src << "        case " << c << " {\n            r = " << (c * 7 % 101) << ";\n            break;\n        }\n";
+    }
+    src << "        default {\n            r = -1;\n        }\n    }\n    return r;\n}\n\n";
+    src << "main {\n    int sum = 0;\n"
+        << "    for (int i = 0; i < " << cases << "; i++) {\n"
+        << "        sum = sum + dispatch(i);\n"
+        << "    }\n    print(sum);\n}\n";
+    return src.str();
+}
+
+// `blocks` independent three-deep loop nests in main
+static string generateNestedLoops(int blocks) {
+    ostringstream src;
+    src << "include<main>\n\nmain {\n    int total = 0;\n";
+    for (int b = 0; b < blocks; b++) {
+        string i = "i" + to_string(b), j = "j" + to_string(b), k = "k" + to_string(b);
+        src << "    for (int " << i << " = 0; " << i << " < 4; " << i << "++) {\n"
+            << "        for (int " << j << " = 0; " << j << " < 4; " << j << "++) {\n"
+            << "            int " << k << " = 0;\n"
+            << "            while (" << k << " < 4) {\n"
+            << "                total = total + " << i << " * " << j << " - " << k << ";\n"
+            << "                " << k << " = " << k << " + 1;\n"
+            << "            }\n"
+            << "        }\n"
+            << "    }\n";
+    }
+    src << "    print(total);\n}\n";
+    return src.str();
+}
+
+// One large function: `blocks` assignments each followed by an if/else on the new name, so
+// compile time that grows with blocks x names shows up here
+static string generateLargeFunction(int blocks) {
+    ostringstream src;
+    src << "include<main>\n\nint branches(int x, int total) {\n";
+    for (int b = 0; b < blocks; b++) {
+        string a = "a" + to_string(b), c = to_string(b % 17 + 1);
+        src << "    int " << a << " = x * " << c << " + total;\n"
+            << "    if (" << a << " > " << c << ") {\n"
+            << "        total = total + " << a << ";\n"
+            << "    } else {\n"
+            << "        total = total - " << c << ";\n"
+            << "    }\n";
+    }
+    src << "    return total;\n}\n\nmain {\n    print(branches(3, 0));\n}\n";
+    return src.str();
+}
+
+struct Workload {
+    string name;
+    function<string(int)> generate;
+    vector<int> sizes;
+};
+
+// === Counting ===
+
+static size_t countNodes(const ASTNodeVariant& node);
+
+static size_t countNodes(const ASTPtr& node) {
+    return node ? countNodes(node->node) : 0;
+}
+
+static size_t countNodes(const vector<ASTPtr>& nodes) {
+    size_t count = 0;
+    for (const auto& n : nodes) count += countNodes(n);
+    return count;
+}
+
+static size_t countNodes(const ASTNodeVariant& node) {
+    return 1 + visit([](const auto& n) -> size_t {
+        using T = decay_t<decltype(n)>;
+        if constexpr (is_same_v<T, BinaryExpr>) return countNodes(n.left) + countNodes(n.right);
+        else if constexpr (is_same_v<T, UnaryExpr>) return countNodes(n.operand);
+        else if constexpr (is_same_v<T, EnumDecl>) return countNodes(n.values);
+        else if constexpr (is_same_v<T, CallExpr>) return countNodes(n.callee) + countNodes(n.args);
+        else if constexpr (is_same_v<T, VarDecl>) return countNodes(n.initializer);
+        else if constexpr (is_same_v<T, BlockStmt>) return countNodes(n.body);
+        else if constexpr (is_same_v<T, FunctionDecl>) return countNodes(n.body);
+        else if constexpr (is_same_v<T, MainDecl>) return countNodes(n.body);
+        else if constexpr (is_same_v<T, IfStmt>) return countNodes(n.condition) + countNodes(n.ifBody) + countNodes(n.elseBody);
+        else if constexpr (is_same_v<T, WhileStmt>) return countNodes(n.condition) + countNodes(n.body);
+        else if constexpr (is_same_v<T, DoWhileStmt>) return countNodes(n.body) + countNodes(n.condition);
+        else if constexpr (is_same_v<T, ForStmt>) return countNodes(n.init) + countNodes(n.condition) + countNodes(n.update) + countNodes(n.body);
+        else if constexpr (is_same_v<T, CaseBlock>) return countNodes(n.value) + countNodes(n.body);
+        else if constexpr (is_same_v<T, SwitchStmt>) return countNodes(n.expression) + countNodes(n.cases) + countNodes(n.defaultBody);
+        else if constexpr (is_same_v<T, ReturnStmt>) return countNodes(n.value);
+        else if constexpr (is_same_v<T, PrintStmt>) return countNodes(n.args);
+        else if constexpr (is_same_v<T, ExpressionStmt>) return countNodes(n.expr);
+        else return 0;
+    }, node);
+}
+
+// TAC instructions are the non-empty lines that are not labels, comments or function markers
+static size_t countTACInstructions(const string& tac) {
+    istringstream in(tac);
+    string line;
+    size_t count = 0;
+    while (getline(in, line)) {
+        line.erase(0, line.find_first_not_of(" \t"));
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (line.empty() || line.back() == ':' || line.rfind("//", 0) == 0) continue;
+        if (line.find("function ") != string::npos &&
+            (line.find(" begin") != string::npos || line.find(" end") != string::npos)) continue;
+        count++;
+    }
+    return count;
+}
+
+// === Driver ===
+
+enum Phase { LEX, PARSE, SCOPE, TYPE, TAC, TAC_OPT, IR, PHASE_COUNT };
+
+struct Sample {
+    double phaseMs[PHASE_COUNT] = {};
+    size_t tokens = 0, nodes = 0, tacInstructions = 0, llvmInstructions = 0;   // TAC as generated
+};
+
+static string readFile(const string& path) {
+    ifstream in(path);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+static Sample runOnce(const string& sourceFile, const string& base) {
+    Sample s;
+    auto now = [] { return chrono::steady_clock::now(); };
+    auto ms = [](auto a, auto b) { return chrono::duration<double, milli>(b - a).count(); };
+
+    auto t0 = now();
+    vector<Token> tokens = lexAndDumpToFile(sourceFile, base + ".tokens.txt");
+    auto t1 = now();
+    auto ast = parseFromFile(tokens);
+    auto t2 = now();
+    performScopeAnalysis(ast, tokens);
+    auto t3 = now();
+    performTypeChecking(ast, tokens);
+    auto t4 = now();
+    // compilerOptions.optimizeTAC is off, so optimizeTAC is timed as a phase of its own
+    generateTAC(ast, base + ".tac.txt");
+    auto t5 = now();
+    string tac = readFile(base + ".tac.txt");
+    s.tacInstructions = countTACInstructions(tac);
+    auto t6 = now();
+    tac = optimizeTAC(tac);
+    auto t7 = now();
+    ofstream(base + ".tac.txt") << tac;
+    auto t8 = now();
+    s.llvmInstructions = compileTACToIR(base + ".tac.txt", base + ".ll");
+    auto t9 = now();
+
+    s.phaseMs[LEX] = ms(t0, t1);
+    s.phaseMs[PARSE] = ms(t1, t2);
+    s.phaseMs[SCOPE] = ms(t2, t3);
+    s.phaseMs[TYPE] = ms(t3, t4);
+    s.phaseMs[TAC] = ms(t4, t5);
+    s.phaseMs[TAC_OPT] = ms(t6, t7);
+    s.phaseMs[IR] = ms(t8, t9);
+    s.tokens = tokens.size();
+    s.nodes = countNodes(ast);
+    return s;
+}
+
+static double median(vector<double> v) {
+    sort(v.begin(), v.end());
+    return v.empty() ? 0 : v[v.size() / 2];
+}
+
+static string rate(double items, double ms) {
+    ostringstream out;
+    double perSec = ms > 0 ? items / (ms / 1000.0) : 0;
+    if (perSec >= 1e6) out << fixed << setprecision(2) << perSec / 1e6 << "M";
+    else if (perSec >= 1e3) out << fixed << setprecision(1) << perSec / 1e3 << "K";
+    else out << fixed << setprecision(0) << perSec;
+    return out.str();
+}
+
+static void printUsage(const char* prog) {
+    cerr << "Usage: " << prog << " [--reps N] [--scale F] [--only workload] [--out dir]\n";
+}
+
+int main(int argc, char* argv[]) {
+    int reps = 5;
+    double scale = 1.0;
+    string only;
+    string outDir = "bench/out";
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--reps" && i + 1 < argc) reps = max(1, stoi(argv[++i]));
+        else if (arg == "--scale" && i + 1 < argc) scale = stod(argv[++i]);
+        else if (arg == "--only" && i + 1 < argc) only = argv[++i];
+        else if (arg == "--out" && i + 1 < argc) outDir = argv[++i];
+        else {
+            printUsage(argv[0]);
+            return arg == "-h" || arg == "--help" ? 0 : EXIT_FAILURE;
+        }
+    }
+
+    compilerOptions.quiet = true;
+    compilerOptions.optimizeTAC = false;
+    fs::create_directories(outDir);
+
+    vector<Workload> workloads = {
+        {"functions", generateFunctions, {50, 200, 800}},
+        {"deep-expr", generateDeepExpressions, {50, 200, 800}},
+        {"switch", generateSwitchChain, {50, 200, 800}},
+        {"loops", generateNestedLoops, {20, 80, 320}},
+        {"large-func", generateLargeFunction, {250, 1000, 4000}},
+    };
+
+    cout << "=== Compiler Benchmark (median of " << reps << " run(s)) ===\n"
+         << "Throughput: lex in tokens/s; parse, scope and type in AST nodes/s;\n"
+         << "tac and tac-opt in generated TAC instructions/s; ir (build + verify) in LLVM instructions/s\n\n";
+    cout << left << setw(11) << "workload" << right << setw(6) << "size"
+         << setw(8) << "tokens" << setw(8) << "nodes" << setw(7) << "tac" << setw(7) << "llvm"
+         << setw(10) << "lex" << setw(10) << "parse" << setw(10) << "scope" << setw(10) << "type"
+         << setw(10) << "tac" << setw(10) << "tac-opt" << setw(10) << "ir" << setw(11) << "total ms" << "\n";
+
+    try {
+        for (const auto& w : workloads) {
+            if (!only.empty() && w.name != only) continue;
+            for (int baseSize : w.sizes) {
+                int size = max(1, static_cast<int>(baseSize * scale));
+                string base = (fs::path(outDir) / (w.name + "_" + to_string(size))).string();
+                string sourceFile = base + ".txt";
+                {
+                    ofstream src(sourceFile);
+                    src << w.generate(size);
+                }
+
+                vector<double> phaseMs[PHASE_COUNT];
+                vector<double> totals;
+                Sample last;
+                for (int r = 0; r < reps; r++) {
+                    last = runOnce(sourceFile, base);
+                    double total = 0;
+                    for (int p = 0; p < PHASE_COUNT; p++) {
+                        phaseMs[p].push_back(last.phaseMs[p]);
+                        total += last.phaseMs[p];
+                    }
+                    totals.push_back(total);
+                }
+
+                double m[PHASE_COUNT];
+                for (int p = 0; p < PHASE_COUNT; p++) m[p] = median(phaseMs[p]);
+
+                cout << left << setw(11) << w.name << right << setw(6) << size
+                     << setw(8) << last.tokens << setw(8) << last.nodes
+                     << setw(7) << last.tacInstructions << setw(7) << last.llvmInstructions
+                     << setw(10) << rate(last.tokens, m[LEX])
+                     << setw(10) << rate(last.nodes, m[PARSE])
+                     << setw(10) << rate(last.nodes, m[SCOPE])
+                     << setw(10) << rate(last.nodes, m[TYPE])
+                     << setw(10) << rate(last.tacInstructions, m[TAC])
+                     << setw(10) << rate(last.tacInstructions, m[TAC_OPT])
+                     << setw(10) << rate(last.llvmInstructions, m[IR])
+                     << setw(11) << fixed << setprecision(2) << median(totals) << "\n";
+            }
+        }
+    } catch (const CompilationError& e) {
+        cerr << "Benchmark input failed to compile: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return 0;
+}
@@ -0,0 +1,256 @@
+#include "../compiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iomanip>
+
+#ifdef _WIN32
+#include <io.h>
+#define dup _dup
+#define dup2 _dup2
+#define close _close
+#define fileno _fileno
+#else
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+// === Output Capture ===
+// The JIT-compiled program prints through the C runtime straight to fd 1, so its output is
+// captured by pointing fd 1 at a file for the duration of the run.
+
+class StdoutCapture {
+private:
+    string path;
+    int savedFd;
+public:
+    explicit StdoutCapture(const string& capturePath) : path(capturePath), savedFd(-1) {
+        cout.flush();
+        fflush(stdout);
+        FILE* file = fopen(path.c_str(), "w");
+        if (!file) return;
+        savedFd = dup(fileno(stdout));
+        dup2(fileno(file), fileno(stdout));
+        fclose(file);
+    }
+
+    ~StdoutCapture() { restore(); }
+
+    void restore() {
+        if (savedFd < 0) return;
+        cout.flush();
+        fflush(stdout);
+        dup2(savedFd, fileno(stdout));
+        close(savedFd);
+        savedFd = -1;
+    }
+
+    string contents() {
+        restore();
+        ifstream in(path, ios::binary);
+        return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    }
+};
+
+// FNV-1a; only used to notice that a backend change altered what a program prints
+static string hashOutput(const string& output) {
+    uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : output) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    ostringstream out;
+    out << hex << setw(16) << setfill('0') << h;
+    return out.str();
+}
+
+// === Baseline ===
+// One line per program: <name> <output hash> <median execute ms>
+
+struct BaselineEntry {
+    string hash;
+    double executeMs = 0;
+};
+
+static map<string, BaselineEntry> readBaseline(const string& filename) {
+    map<string, BaselineEntry> baseline;
+    ifstream in(filename);
+    string line;
+    while (getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        istringstream fields(line);
+        string name;
+        BaselineEntry entry;
+        if (fields >> name >> entry.hash >> entry.executeMs) baseline[name] = entry;
+    }
+    return baseline;
+}
+
+static bool writeBaseline(const string& filename, const map<string, BaselineEntry>& baseline) {
+    ofstream out(filename);
+    if (!out.is_open()) {
+        cerr << "Failed to write baseline file: " << filename << endl;
+        return false;
+    }
+    out << "# name output-hash execute-ms (regenerate with: make bench-runtime BENCH_RUNTIME_ARGS=--update-baseline)\n";
+    for (const auto& [name, entry] : baseline) {
+        out << name << " " << entry.hash << " " << fixed << setprecision(3) << entry.executeMs << "\n";
+    }
+    return true;
+}
+
+// === Driver ===
+
+struct RuntimeSample {
+    double compileMs = 0;   // source -> TAC (-> checked AST with --backend ast)
+    RunStats run;
+    string output;
+};
+
+static RuntimeSample runOnce(const string& sourceFile, const string& base) {
+    RuntimeSample s;
+    auto start = chrono::steady_clock::now();
+    vector<Token> tokens = lexAndDumpToFile(sourceFile, base + ".tokens.txt");
+    auto ast = parseFromFile(tokens);
+    performScopeAnalysis(ast, tokens);
+    performTypeChecking(ast, tokens);
+    if (compilerOptions.backend == Backend::TAC) {
+        generateTAC(ast, base + ".tac.txt");
+    }
+    s.compileMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    StdoutCapture capture(base + ".out.txt");
+    s.run = compilerOptions.backend == Backend::AST ? executeASTProgram(ast) : executeTACProgram(base + ".tac.txt");
+    s.output = capture.contents();
+    return s;
+}
+
+static double median(vector<double> v) {
+    sort(v.begin(), v.end());
+    return v.empty() ? 0 : v[v.size() / 2];
+}
+
+static void printUsage(const char* prog) {
+    cerr << "Usage: " << prog << " [-O0..-O3] [--backend tac|ast] [--no-tac-opt] [--reps N] [--only program] [--programs dir] [--baseline file]\n"
+         << "       [--threshold F] [--out dir] [--update-baseline]\n";
+}
+
+int main(int argc, char* argv[]) {
+    int reps = 5;
+    string only;
+    string programDir = "bench/programs";
+    string baselineFile = "bench/runtime_baseline.txt";
+    string outDir = "bench/out/runtime";
+    double threshold = 1.10;
+    bool updateBaseline = false;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--reps" && i + 1 < argc) reps = max(1, stoi(argv[++i]));
+        else if (arg == "--only" && i + 1 < argc) only = argv[++i];
+        else if (arg == "--programs" && i + 1 < argc) programDir = argv[++i];
+        else if (arg == "--baseline" && i + 1 < argc) baselineFile = argv[++i];
+        else if (arg == "--threshold" && i + 1 < argc) threshold = stod(argv[++i]);
+        else if (arg == "--out" && i + 1 < argc) outDir = argv[++i];
+        else if (arg == "--update-baseline") updateBaseline = true;
+        else if (arg == "--no-tac-opt") compilerOptions.optimizeTAC = false;
+        else if (arg == "--backend" && i + 1 < argc) {
+            string backend = argv[++i];
+            compilerOptions.backend = backend == "ast" ? Backend::AST : Backend::TAC;
+        }
+        else if (arg.size() == 3 && arg.compare(0, 2, "-O") == 0 && arg[2] >= '0' && arg[2] <= '3') {
+            compilerOptions.optLevel = arg[2] - '0';
+        }
+        else {
+            printUsage(argv[0]);
+            return arg == "-h" || arg == "--help" ? 0 : EXIT_FAILURE;
+        }
+    }
+
+    vector<fs::path> programs;
+    error_code ec;
+    for (const auto& entry : fs::directory_iterator(programDir, ec)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".txt") programs.push_back(entry.path());
+    }
+    sort(programs.begin(), programs.end());
+    if (programs.empty()) {
+        cerr << "No programs found in " << programDir << "\n";
+        return EXIT_FAILURE;
+    }
+
+    compilerOptions.quiet = true;
+    // Compile everything before main runs so execute times only cover generated code
+    compilerOptions.lazyJIT = false;
+    fs::create_directories(outDir);
+    map<string, BaselineEntry> baseline = readBaseline(baselineFile);
+
+    cout << "=== Runtime Benchmark (-O" << compilerOptions.optLevel
+         << (compilerOptions.backend == Backend::AST ? ", AST backend" : "") << ", median of " << reps << " run(s)) ===\n"
+         << "compile = source to TAC (AST: to checked AST); build = to verified, optimized LLVM IR;\n"
+         << "jit = machine code (eager); "
+         << "execute = time spent in main, compared against " << baselineFile << "\n\n";
+    cout << left << setw(18) << "program" << right << setw(11) << "compile" << setw(10) << "build"
+         << setw(10) << "jit" << setw(12) << "execute" << setw(12) << "baseline" << setw(9) << "ratio"
+         << "  result\n";
+
+    int mismatches = 0, slower = 0;
+    try {
+        for (const auto& program : programs) {
+            string name = program.stem().string();
+            if (!only.empty() && name != only) continue;
+            string base = (fs::path(outDir) / name).string();
+
+            vector<double> compileMs, buildMs, jitMs, executeMs;
+            RuntimeSample last;
+            for (int r = 0; r < reps; r++) {
+                last = runOnce(program.string(), base);
+                compileMs.push_back(last.compileMs);
+                buildMs.push_back(last.run.buildMs);
+                jitMs.push_back(last.run.jitMs);
+                executeMs.push_back(last.run.executeMs);
+            }
+
+            string hash = hashOutput(last.output);
+            double exec = median(executeMs);
+            cout << left << setw(18) << name << right << fixed << setprecision(2)
+                 << setw(11) << median(compileMs) << setw(10) << median(buildMs)
+                 << setw(10) << median(jitMs) << setw(12) << exec;
+
+            auto it = baseline.find(name);
+            if (updateBaseline) {
+                baseline[name] = BaselineEntry{hash, exec};
+                cout << setw(12) << "-" << setw(9) << "-" << "  recorded\n";
+            } else if (it == baseline.end()) {
+                cout << setw(12) << "-" << setw(9) << "-" << "  no baseline\n";
+            } else {
+                double ratio = it->second.executeMs > 0 ? exec / it->second.executeMs : 0;
+                string result = "ok";
+                if (it->second.hash != hash) {
+                    result = "OUTPUT CHANGED";
+                    mismatches++;
+                } else if (ratio > threshold) {
+                    result = "slower";
+                    slower++;
+                } else if (ratio > 0 && ratio < 1.0 / threshold) {
+                    result = "faster";
+                }
+                cout << setw(12) << it->second.executeMs << setw(9) << setprecision(3) << ratio
+                     << "  " << result << "\n";
+            }
+        }
+    } catch (const CompilationError& e) {
+        cerr << "Runtime benchmark program failed to compile: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    if (updateBaseline) {
+        return writeBaseline(baselineFile, baseline) ? 0 : EXIT_FAILURE;
+    }
+
+    cout << "\n" << mismatches << " output mismatch(es), " << slower << " program(s) slower than "
+         << fixed << setprecision(2) << threshold << "x baseline\n";
+    return mismatches == 0 ? 0 : EXIT_FAILURE;
+}
@@ -0,0 +1,739 @@
+#include "backend.h"
+
+#include <llvm/Transforms/Utils/Local.h>
+
+#include <chrono>
+
+using namespace llvm;
+using namespace std;
+
+// A local variable's entry-block alloca
+struct CodegenVariable {
+    Value* address;
+    VarType type;
+};
+
+struct CodegenFunction {
+    Function* func;
+    vector<VarType> paramTypes;
+    VarType returnType;
+};
+
+using TypedValue = pair<Value*, VarType>;
+
+static VarType varTypeOf(TokenType type) {
+    switch (type) {
+        case T_INT: return VarType::INT;
+        case T_FLOAT: return VarType::FLOAT;
+        case T_DOUBLE: return VarType::DOUBLE;
+        case T_CHAR: return VarType::CHAR;
+        case T_STRING: return VarType::STRING;
+        case T_BOOL: return VarType::BOOL;
+        case T_VOID: return VarType::VOID;
+        default: return VarType::INT;
+    }
+}
+
+// Lowers the type-checked AST straight to LLVM IR. Values follow the TAC backend's
+// representation (bool as i32, char as i8, float literals as double, comparisons as i32)
+// so both backends print the same output for well-formed programs.
+class ASTCodeGenerator {
+private:
+    unique_ptr<LLVMContext> context;
+    LLVMContext& ctx;
+    unique_ptr<Module> module;
+    IRBuilder<> builder;
+
+    Type* voidTy;
+    Type* int1Ty;
+    Type* int32Ty;
+    Type* int8Ty;
+    Type* floatTy;
+    Type* doubleTy;
+    Type* ptrTy;
+
+    unique_ptr<PrintLowering> printer;
+
+    Function* currentFunc;
+    VarType currentReturnType;
+
+    vector<map<string, CodegenVariable>> scopes;  // innermost scope last
+    map<string, int> enumValues;
+    map<string, CodegenFunction> functions;
+    vector<BasicBlock*> breakTargets;
+
+public:
+    ASTCodeGenerator() : context(make_unique<LLVMContext>()), ctx(*context), builder(ctx),
+                         currentFunc(nullptr), currentReturnType(VarType::VOID) {
+        module = make_unique<Module>("ASTModule", ctx);
+
+        voidTy = Type::getVoidTy(ctx);
+        int1Ty = Type::getInt1Ty(ctx);
+        int32Ty = Type::getInt32Ty(ctx);
+        int8Ty = Type::getInt8Ty(ctx);
+        floatTy = Type::getFloatTy(ctx);
+        doubleTy = Type::getDoubleTy(ctx);
+        ptrTy = PointerType::getUnqual(int8Ty);
+
+        printer = make_unique<PrintLowering>(*module);
+    }
+
+    LoweredProgram lower(const vector<ASTPtr>& ast) {
+        // Signatures and enums first, so a body can call a function defined below it
+        for (const auto& node : ast) {
+            if (!node) continue;
+            if (auto proto = get_if<FunctionProto>(&node->node)) {
+                declareFunction(proto->name, proto->returnType, proto->params);
+            } else if (auto func = get_if<FunctionDecl>(&node->node)) {
+                declareFunction(func->name, func->returnType, func->params);
+            } else if (holds_alternative<MainDecl>(node->node)) {
+                declareFunction("main", T_INT, {});
+            } else if (auto enm = get_if<EnumDecl>(&node->node)) {
+                registerEnum(*enm);
+            }
+        }
+
+        for (const auto& node : ast) {
+            if (!node) continue;
+            if (auto func = get_if<FunctionDecl>(&node->node)) {
+                lowerFunction(*func);
+            } else if (auto mainDecl = get_if<MainDecl>(&node->node)) {
+                lowerMain(*mainDecl);
+            }
+        }
+
+        LoweredProgram program;
+        program.module = std::move(module);
+        program.context = std::move(context);
+        return program;
+    }
+
+private:
+    // === Types and Values ===
+
+    Type* getLLVMType(VarType type) {
+        switch (type) {
+            case VarType::INT: return int32Ty;
+            case VarType::BOOL: return int32Ty;
+            case VarType::FLOAT: return floatTy;
+            case VarType::DOUBLE: return doubleTy;
+            case VarType::CHAR: return int8Ty;
+            case VarType::STRING: return ptrTy;
+            case VarType::VOID: return voidTy;
+            default: return int32Ty;
+        }
+    }
+
+    Constant* zeroValue(VarType type) {
+        switch (type) {
+            case VarType::FLOAT: return ConstantFP::get(floatTy, 0.0);
+            case VarType::DOUBLE: return ConstantFP::get(doubleTy, 0.0);
+            case VarType::CHAR: return ConstantInt::get(int8Ty, 0);
+            case VarType::STRING: return ConstantPointerNull::get(cast<PointerType>(ptrTy));
+            default: return ConstantInt::get(int32Ty, 0);
+        }
+    }
+
+    Constant* stringConstant(const string& str) {
+        return printer->stringConstant(builder, str);
+    }
+
+    Value* convertToType(Value* val, VarType toType) {
+        Type* valType = val->getType();
+        Type* targetType = getLLVMType(toType);
+        if (valType == targetType) return val;
+
+        // Comparison results, chars and bools widen to i32 before anything else
+        if (valType->isIntegerTy() && targetType->isIntegerTy()) {
+            return builder.CreateZExtOrTrunc(val, targetType);
+        }
+        if (valType->isIntegerTy() && targetType->isFloatingPointTy()) {
+            if (!valType->isIntegerTy(32)) val = builder.CreateZExt(val, int32Ty);
+            return builder.CreateSIToFP(val, targetType);
+        }
+        if (valType->isFloatingPointTy() && targetType->isFloatingPointTy()) {
+            return builder.CreateFPCast(val, targetType);
+        }
+        if (valType->isFloatingPointTy() && targetType->isIntegerTy()) {
+            return builder.CreateFPToSI(val, targetType);
+        }
+        throw runtime_error("unsupported type conversion");
+    }
+
+    // Branch condition: true when the value is non-zero (non-null for strings)
+    Value* toCondition(const TypedValue& value) {
+        Value* val = value.first;
+        Type* type = val->getType();
+        if (type->isIntegerTy(1)) return val;
+        if (type->isFloatingPointTy()) return builder.CreateFCmpUNE(val, ConstantFP::get(type, 0.0));
+        if (type->isPointerTy()) return builder.CreateIsNotNull(val);
+        return builder.CreateICmpNE(val, ConstantInt::get(type, 0));
+    }
+
+    // === Blocks ===
+
+    // Blocks are created detached and appended when code starts flowing into them, so the
+    // function's block order follows the source
+    BasicBlock* newBlock(const string& name) {
+        return BasicBlock::Create(ctx, name);
+    }
+
+    void startBlock(BasicBlock* block) {
+        block->insertInto(currentFunc);
+        builder.SetInsertPoint(block);
+    }
+
+    // Falls through to `target` unless the current block already ended (return, break)
+    void jumpTo(BasicBlock* target) {
+        if (!builder.GetInsertBlock()->getTerminator()) {
+            builder.CreateBr(target);
+        }
+    }
+
+    // mem2reg only promotes allocas in the entry block, so every local is created there
+    AllocaInst* createEntryAlloca(Type* type, const string& name) {
+        BasicBlock& entry = currentFunc->getEntryBlock();
+        IRBuilder<> entryBuilder(&entry, entry.begin());
+        return entryBuilder.CreateAlloca(type, nullptr, name);
+    }
+
+    // === Declarations ===
+
+    void declareFunction(const string& name, TokenType returnType, const vector<pair<TokenType, string>>& params) {
+        if (functions.count(name)) return;  // prototype followed by its definition
+
+        CodegenFunction info;
+        info.returnType = varTypeOf(returnType);
+        vector<Type*> llvmParamTypes;
+        for (const auto& param : params) {
+            info.paramTypes.push_back(varTypeOf(param.first));
+            llvmParamTypes.push_back(getLLVMType(info.paramTypes.back()));
+        }
+
+        FunctionType* funcTy = FunctionType::get(getLLVMType(info.returnType), llvmParamTypes, false);
+        info.func = Function::Create(funcTy, Function::ExternalLinkage, name, module.get());
+        size_t i = 0;
+        for (Argument& arg : info.func->args()) {
+            arg.setName(params[i++].second);
+        }
+        functions[name] = info;
+    }
+
+    void registerEnum(const EnumDecl& decl) {
+        if (!decl.values) return;
+        if (auto list = get_if<EnumValueList>(&decl.values->node)) {
+            int value = 0;
+            for (const auto& name : list->values) {
+                enumValues[name] = value++;
+            }
+        }
+    }
+
+    CodegenVariable* lookupVariable(const string& name) {
+        for (auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope) {
+            auto it = scope->find(name);
+            if (it != scope->end()) return &it->second;
+        }
+        return nullptr;
+    }
+
+    // === Functions ===
+
+    void beginFunction(Function* func, VarType returnType) {
+        currentFunc = func;
+        currentReturnType = returnType;
+        scopes.clear();
+        breakTargets.clear();
+        startBlock(newBlock("entry"));
+    }
+
+    // Falling off the end returns a zero of the return type, like the TAC backend; code after
+    // a return or break was emitted into blocks nothing branches to, which are dropped here
+    void finishFunction() {
+        if (!builder.GetInsertBlock()->getTerminator()) {
+            emitDefaultReturn();
+        }
+        removeUnreachableBlocks(*currentFunc);
+        currentFunc = nullptr;
+    }
+
+    void emitDefaultReturn() {
+        if (currentReturnType == VarType::VOID) {
+            builder.CreateRetVoid();
+        } else {
+            builder.CreateRet(zeroValue(currentReturnType));
+        }
+    }
+
+    void lowerFunction(const FunctionDecl& func) {
+        TRACE_SCOPE("lowerFunction", func.name);
+        const CodegenFunction& info = functions[func.name];
+        beginFunction(info.func, info.returnType);
+
+        scopes.emplace_back();
+        size_t i = 0;
+        for (Argument& arg : info.func->args()) {
+            VarType type = info.paramTypes[i];
+            const string& name = func.params[i].second;
+            AllocaInst* slot = createEntryAlloca(getLLVMType(type), name);
+            builder.CreateStore(&arg, slot);
+            scopes.back()[name] = {slot, type};
+            i++;
+        }
+        lowerStatements(func.body);
+        scopes.pop_back();
+
+        finishFunction();
+    }
+
+    void lowerMain(const MainDecl& main) {
+        TRACE_SCOPE("lowerFunction", "main");
+        beginFunction(functions["main"].func, VarType::INT);
+
+        scopes.emplace_back();
+        lowerStatements(main.body);
+        scopes.pop_back();
+
+        finishFunction();
+    }
+
+    // === Statements ===
+
+    void lowerStatements(const vector<ASTPtr>& body) {
+        for (const auto& stmt : body) {
+            if (stmt) lowerStatement(*stmt);
+        }
+    }
+
+    void lowerScopedStatements(const vector<ASTPtr>& body) {
+        scopes.emplace_back();
+        lowerStatements(body);
+        scopes.pop_back();
+    }
+
+    void lowerStatement(const ASTNode& node) {
+        // Statements after a return or break land in a fresh block nothing branches to
+        if (builder.GetInsertBlock()->getTerminator()) {
+            startBlock(newBlock("dead"));
+        }
+
+        visit([this](const auto& n) {
+            using T = decay_t<decltype(n)>;
+
+            if constexpr (is_same_v<T, VarDecl>) lowerVarDecl(n);
+            else if constexpr (is_same_v<T, BlockStmt>) lowerScopedStatements(n.body);
+            else if constexpr (is_same_v<T, IfStmt>) lowerIf(n);
+            else if constexpr (is_same_v<T, WhileStmt>) lowerWhile(n);
+            else if constexpr (is_same_v<T, DoWhileStmt>) lowerDoWhile(n);
+            else if constexpr (is_same_v<T, ForStmt>) lowerFor(n);
+            else if constexpr (is_same_v<T, SwitchStmt>) lowerSwitch(n);
+            else if constexpr (is_same_v<T, ReturnStmt>) lowerReturn(n);
+            else if constexpr (is_same_v<T, PrintStmt>) lowerPrint(n.args);
+            else if constexpr (is_same_v<T, BreakStmt>) {
+                if (!breakTargets.empty()) builder.CreateBr(breakTargets.back());
+            }
+            else if constexpr (is_same_v<T, ExpressionStmt>) {
+                if (n.expr) lowerExpr(*n.expr);
+            }
+            else if constexpr (is_same_v<T, EnumDecl>) registerEnum(n);
+            else if constexpr (is_same_v<T, IncludeStmt> || is_same_v<T, FunctionProto> ||
+                               is_same_v<T, FunctionDecl> || is_same_v<T, MainDecl>) {
+                // Only meaningful at the top level, where lower() has handled them
+            }
+            else lowerExpr(n);
+        }, node.node);
+    }
+
+    void lowerVarDecl(const VarDecl& decl) {
+        VarType type = varTypeOf(decl.type);
+        Value* init;
+        if (decl.initializer) {
+            init = convertToType(lowerExpr(*decl.initializer).first, type);
+        } else {
+            init = type == VarType::STRING ? stringConstant("") : zeroValue(type);
+        }
+
+        // Registered after the initializer, which still sees any outer variable of the same name
+        AllocaInst* slot = createEntryAlloca(getLLVMType(type), decl.name);
+        builder.CreateStore(init, slot);
+        scopes.back()[decl.name] = {slot, type};
+    }
+
+    void lowerIf(const IfStmt& stmt) {
+        Value* cond = toCondition(lowerExpr(*stmt.condition));
+        BasicBlock* thenBlock = newBlock("if.then");
+        BasicBlock* endBlock = newBlock("if.end");
+        BasicBlock* elseBlock = stmt.elseBody.empty() ? endBlock : newBlock("if.else");
+        builder.CreateCondBr(cond, thenBlock, elseBlock);
+
+        startBlock(thenBlock);
+        lowerScopedStatements(stmt.ifBody);
+        jumpTo(endBlock);
+
+        if (!stmt.elseBody.empty()) {
+            startBlock(elseBlock);
+            lowerScopedStatements(stmt.elseBody);
+            jumpTo(endBlock);
+        }
+        startBlock(endBlock);
+    }
+
+    void lowerWhile(const WhileStmt& stmt) {
+        BasicBlock* condBlock = newBlock("while.cond");
+        BasicBlock* bodyBlock = newBlock("while.body");
+        BasicBlock* endBlock = newBlock("while.end");
+
+        jumpTo(condBlock);
+        startBlock(condBlock);
+        builder.CreateCondBr(toCondition(lowerExpr(*stmt.condition)), bodyBlock, endBlock);
+
+        startBlock(bodyBlock);
+        breakTargets.push_back(endBlock);
+        lowerScopedStatements(stmt.body);
+        breakTargets.pop_back();
+        jumpTo(condBlock);
+
+        startBlock(endBlock);
+    }
+
+    void lowerDoWhile(const DoWhileStmt& stmt) {
+        BasicBlock* bodyBlock = newBlock("do.body");
+        BasicBlock* condBlock = newBlock("do.cond");
+        BasicBlock* endBlock = newBlock("do.end");
+
+        jumpTo(bodyBlock);
+        startBlock(bodyBlock);
+        breakTargets.push_back(endBlock);
+        lowerStatement(*stmt.body);
+        breakTargets.pop_back();
+        jumpTo(condBlock);
+
+        startBlock(condBlock);
+        builder.CreateCondBr(toCondition(lowerExpr(*stmt.condition)), bodyBlock, endBlock);
+        startBlock(endBlock);
+    }
+
+    void lowerFor(const ForStmt& stmt) {
+        BasicBlock* condBlock = newBlock("for.cond");
+        BasicBlock* bodyBlock = newBlock("for.body");
+        BasicBlock* stepBlock = newBlock("for.step");
+        BasicBlock* endBlock = newBlock("for.end");
+
+        // The loop variable lives in its own scope around the whole loop
+        scopes.emplace_back();
+        if (stmt.init) lowerStatement(*stmt.init);
+
+        jumpTo(condBlock);
+        startBlock(condBlock);
+        if (stmt.condition) {
+            builder.CreateCondBr(toCondition(lowerExpr(*stmt.condition)), bodyBlock, endBlock);
+        } else {
+            builder.CreateBr(bodyBlock);
+        }
+
+        startBlock(bodyBlock);
+        breakTargets.push_back(endBlock);
+        lowerStatement(*stmt.body);
+        breakTargets.pop_back();
+        jumpTo(stepBlock);
+
+        startBlock(stepBlock);
+        if (stmt.update) lowerExpr(*stmt.update);
+        jumpTo(condBlock);
+
+        startBlock(endBlock);
+        scopes.pop_back();
+    }
+
+    // A single switch instruction; case bodies are laid out in source order and fall through
+    // into the next case (the last one into default) unless they break
+    void lowerSwitch(const SwitchStmt& stmt) {
+        Value* scrutinee = convertToType(lowerExpr(*stmt.expression).first, VarType::INT);
+
+        vector<const CaseBlock*> cases;
+        vector<ConstantInt*> caseValues;
+        for (const auto& node : stmt.cases) {
+            if (auto caseBlock = get_if<CaseBlock>(&node->node)) {
+                auto value = dyn_cast<ConstantInt>(convertToType(lowerExpr(*caseBlock->value).first, VarType::INT));
+                if (!value) {
+                    throw runtime_error("case value is not a constant");
+                }
+                cases.push_back(caseBlock);
+                caseValues.push_back(value);
+            }
+        }
+
+        BasicBlock* endBlock = newBlock("switch.end");
+        BasicBlock* defaultBlock = stmt.defaultBody.empty() ? endBlock : newBlock("switch.default");
+        SwitchInst* inst = builder.CreateSwitch(scrutinee, defaultBlock, cases.size());
+
+        breakTargets.push_back(endBlock);
+        set<int64_t> seen;
+        for (size_t i = 0; i < cases.size(); i++) {
+            BasicBlock* caseBlock = newBlock("switch.case");
+            // A repeated value keeps jumping to its first case, as in the TAC if-chain
+            if (seen.insert(caseValues[i]->getSExtValue()).second) {
+                inst->addCase(caseValues[i], caseBlock);
+            }
+            jumpTo(caseBlock);
+            startBlock(caseBlock);
+            lowerScopedStatements(cases[i]->body);
+        }
+        if (!stmt.defaultBody.empty()) {
+            jumpTo(defaultBlock);
+            startBlock(defaultBlock);
+            lowerScopedStatements(stmt.defaultBody);
+        }
+        breakTargets.pop_back();
+
+        jumpTo(endBlock);
+        startBlock(endBlock);
+    }
+
+    void lowerReturn(const ReturnStmt& stmt) {
+        if (!stmt.value || currentReturnType == VarType::VOID) {
+            if (stmt.value) lowerExpr(*stmt.value);
+            emitDefaultReturn();
+            return;
+        }
+        builder.CreateRet(convertToType(lowerExpr(*stmt.value).first, currentReturnType));
+    }
+
+    void lowerPrint(const vector<ASTPtr>& args) {
+        vector<PrintPiece> pieces;
+        for (const auto& arg : args) {
+            if (auto str = get_if<::StringLiteral>(&arg->node)) {
+                pieces.push_back({processEscapes(str->value)});
+                continue;
+            }
+            auto [val, type] = lowerExpr(*arg);
+            if (type != VarType::VOID) pieces.push_back({"", val});
+        }
+        printer->emit(builder, pieces);
+    }
+
+    // === Expressions ===
+
+    TypedValue lowerExpr(const ASTNode& node) {
+        return visit([this](const auto& n) { return lowerExpr(n); }, node.node);
+    }
+
+    template <typename T>
+    TypedValue lowerExpr(const T& n) {
+        if constexpr (is_same_v<T, IntLiteral>) {
+            return {ConstantInt::get(int32Ty, n.value, true), VarType::INT};
+        }
+        else if constexpr (is_same_v<T, FloatLiteral>) {
+            return {ConstantFP::get(doubleTy, n.value), VarType::DOUBLE};
+        }
+        else if constexpr (is_same_v<T, ::StringLiteral>) {
+            return {stringConstant(processEscapes(n.value)), VarType::STRING};
+        }
+        else if constexpr (is_same_v<T, CharLiteral>) {
+            return {ConstantInt::get(int8Ty, n.value), VarType::CHAR};
+        }
+        else if constexpr (is_same_v<T, BoolLiteral>) {
+            return {ConstantInt::get(int32Ty, n.value ? 1 : 0), VarType::BOOL};
+        }
+        else if constexpr (is_same_v<T, Identifier>) return lowerIdentifier(n);
+        else if constexpr (is_same_v<T, BinaryExpr>) return lowerBinary(n);
+        else if constexpr (is_same_v<T, UnaryExpr>) return lowerUnary(n);
+        else if constexpr (is_same_v<T, CallExpr>) return lowerCall(n);
+        else throw runtime_error("statement used as an expression");
+    }
+
+    TypedValue lowerIdentifier(const Identifier& id) {
+        if (CodegenVariable* var = lookupVariable(id.name)) {
+            return {builder.CreateLoad(getLLVMType(var->type), var->address, id.name), var->type};
+        }
+        auto it = enumValues.find(id.name);
+        if (it != enumValues.end()) {
+            return {ConstantInt::get(int32Ty, it->second), VarType::INT};
+        }
+        throw runtime_error("unknown identifier '" + id.name + "'");
+    }
+
+    CodegenVariable& assignable(const ASTNode& node) {
+        auto id = get_if<Identifier>(&node.node);
+        CodegenVariable* var = id ? lookupVariable(id->name) : nullptr;
+        if (!var) {
+            throw runtime_error("assignment target is not a variable");
+        }
+        return *var;
+    }
+
+    TypedValue lowerBinary(const BinaryExpr& expr) {
+        // The parser represents "(expr)" as BinaryExpr(T_LPAREN, expr, nullptr)
+        if (expr.op == T_LPAREN || !expr.right) {
+            return lowerExpr(*expr.left);
+        }
+        if (expr.op == T_ASSIGNOP) {
+            CodegenVariable& var = assignable(*expr.left);
+            Value* val = convertToType(lowerExpr(*expr.right).first, var.type);
+            builder.CreateStore(val, var.address);
+            return {val, var.type};
+        }
+        if (expr.op == T_AND || expr.op == T_OR) {
+            return lowerLogical(expr);
+        }
+
+        TypedValue left = lowerExpr(*expr.left);
+        TypedValue right = lowerExpr(*expr.right);
+        Value* l = left.first;
+        Value* r = right.first;
+
+        // Bitwise, shift and modulo operate on ints
+        switch (expr.op) {
+            case T_MODULO:
+            case T_BITAND: case T_BITOR: case T_BITXOR:
+            case T_BITLSHIFT: case T_BITRSHIFT: {
+                l = convertToType(l, VarType::INT);
+                r = convertToType(r, VarType::INT);
+                Value* result = nullptr;
+                if (expr.op == T_MODULO) result = builder.CreateSRem(l, r);
+                else if (expr.op == T_BITAND) result = builder.CreateAnd(l, r);
+                else if (expr.op == T_BITOR) result = builder.CreateOr(l, r);
+                else if (expr.op == T_BITXOR) result = builder.CreateXor(l, r);
+                else if (expr.op == T_BITLSHIFT) result = builder.CreateShl(l, r);
+                else result = builder.CreateAShr(l, r);
+                return {result, VarType::INT};
+            }
+            default:
+                break;
+        }
+
+        // Otherwise the wider floating type wins; chars and bools widen to int
+        VarType type = VarType::INT;
+        if (l->getType()->isDoubleTy() || r->getType()->isDoubleTy()) type = VarType::DOUBLE;
+        else if (l->getType()->isFloatTy() || r->getType()->isFloatTy()) type = VarType::FLOAT;
+        else if (l->getType()->isPointerTy() && r->getType()->isPointerTy()) type = VarType::STRING;
+        if (type != VarType::STRING) {
+            l = convertToType(l, type);
+            r = convertToType(r, type);
+        }
+        bool isFloat = type == VarType::FLOAT || type == VarType::DOUBLE;
+
+        Value* cmp = nullptr;
+        switch (expr.op) {
+            case T_PLUS: return {isFloat ? builder.CreateFAdd(l, r) : builder.CreateAdd(l, r), type};
+            case T_MINUS: return {isFloat ? builder.CreateFSub(l, r) : builder.CreateSub(l, r), type};
+            case T_MULTIPLY: return {isFloat ? builder.CreateFMul(l, r) : builder.CreateMul(l, r), type};
+            case T_DIVIDE: return {isFloat ? builder.CreateFDiv(l, r) : builder.CreateSDiv(l, r), type};
+            case T_EQUALOP: cmp = isFloat ? builder.CreateFCmpOEQ(l, r) : builder.CreateICmpEQ(l, r); break;
+            case T_NE: cmp = isFloat ? builder.CreateFCmpONE(l, r) : builder.CreateICmpNE(l, r); break;
+            case T_LT: cmp = isFloat ? builder.CreateFCmpOLT(l, r) : builder.CreateICmpSLT(l, r); break;
+            case T_GT: cmp = isFloat ? builder.CreateFCmpOGT(l, r) : builder.CreateICmpSGT(l, r); break;
+            case T_LE: cmp = isFloat ? builder.CreateFCmpOLE(l, r) : builder.CreateICmpSLE(l, r); break;
+            case T_GE: cmp = isFloat ? builder.CreateFCmpOGE(l, r) : builder.CreateICmpSGE(l, r); break;
+            default: throw runtime_error("unsupported binary operator");
+        }
+        return {builder.CreateZExt(cmp, int32Ty), VarType::BOOL};
+    }
+
+    // && and || only evaluate their right operand when the left one does not decide the result
+    TypedValue lowerLogical(const BinaryExpr& expr) {
+        bool isAnd = expr.op == T_AND;
+        Value* left = toCondition(lowerExpr(*expr.left));
+        BasicBlock* leftBlock = builder.GetInsertBlock();
+        BasicBlock* rightBlock = newBlock(isAnd ? "and.rhs" : "or.rhs");
+        BasicBlock* endBlock = newBlock(isAnd ? "and.end" : "or.end");
+        if (isAnd) builder.CreateCondBr(left, rightBlock, endBlock);
+        else builder.CreateCondBr(left, endBlock, rightBlock);
+
+        startBlock(rightBlock);
+        Value* right = toCondition(lowerExpr(*expr.right));
+        BasicBlock* rightEnd = builder.GetInsertBlock();
+        builder.CreateBr(endBlock);
+
+        startBlock(endBlock);
+        PHINode* phi = builder.CreatePHI(int1Ty, 2);
+        phi->addIncoming(ConstantInt::get(int1Ty, isAnd ? 0 : 1), leftBlock);
+        phi->addIncoming(right, rightEnd);
+        return {builder.CreateZExt(phi, int32Ty), VarType::BOOL};
+    }
+
+    TypedValue lowerUnary(const UnaryExpr& expr) {
+        if (expr.op == T_INCREMENT || expr.op == T_DECREMENT) {
+            CodegenVariable& var = assignable(*expr.operand);
+            Type* type = getLLVMType(var.type);
+            Value* oldValue = builder.CreateLoad(type, var.address);
+            Value* newValue;
+            if (type->isFloatingPointTy()) {
+                Value* one = ConstantFP::get(type, 1.0);
+                newValue = expr.op == T_INCREMENT ? builder.CreateFAdd(oldValue, one) : builder.CreateFSub(oldValue, one);
+            } else {
+                Value* one = ConstantInt::get(type, 1);
+                newValue = expr.op == T_INCREMENT ? builder.CreateAdd(oldValue, one) : builder.CreateSub(oldValue, one);
+            }
+            builder.CreateStore(newValue, var.address);
+            return {expr.isPostfix ? oldValue : newValue, var.type};
+        }
+
+        TypedValue operand = lowerExpr(*expr.operand);
+        if (expr.op == T_NOT) {
+            return {builder.CreateZExt(builder.CreateNot(toCondition(operand)), int32Ty), VarType::BOOL};
+        }
+        if (expr.op == T_MINUS) {
+            if (operand.first->getType()->isFloatingPointTy()) {
+                return {builder.CreateFNeg(operand.first), operand.second};
+            }
+            return {builder.CreateNeg(convertToType(operand.first, VarType::INT)), VarType::INT};
+        }
+        return operand;
+    }
+
+    TypedValue lowerCall(const CallExpr& expr) {
+        auto callee = get_if<Identifier>(&expr.callee->node);
+        if (!callee) {
+            throw runtime_error("call target is not a function name");
+        }
+        if (callee->name == "print") {
+            lowerPrint(expr.args);
+            return {nullptr, VarType::VOID};
+        }
+
+        auto it = functions.find(callee->name);
+        if (it == functions.end()) {
+            throw runtime_error("call to undeclared function '" + callee->name + "'");
+        }
+        const CodegenFunction& info = it->second;
+
+        vector<Value*> args;
+        for (size_t i = 0; i < expr.args.size(); i++) {
+            Value* arg = lowerExpr(*expr.args[i]).first;
+            if (i < info.paramTypes.size()) arg = convertToType(arg, info.paramTypes[i]);
+            args.push_back(arg);
+        }
+        return {builder.CreateCall(info.func, args), info.returnType};
+    }
+};
+
+LoweredProgram lowerAST(const vector<ASTPtr>& ast) {
+    PhaseTimer timer("ir-build");
+    try {
+        ASTCodeGenerator generator;
+        LoweredProgram program = generator.lower(ast);
+        if (!compilerOptions.quiet) {
+            cout << "LLVM IR generation successful (AST backend)." << endl;
+        }
+        return program;
+    } catch (const exception& e) {
+        cerr << "Code Generation Error: " << e.what() << endl;
+        throw CompilationError("LLVM IR generation failed");
+    }
+}
+
+RunStats executeASTProgram(const vector<ASTPtr>& ast, const string& cacheKey) {
+    auto buildStart = chrono::steady_clock::now();
+    return executeLoweredProgram(lowerAST(ast), cacheKey, buildStart);
+}
+
+size_t compileASTToIR(const vector<ASTPtr>& ast, const string& irFile) {
+    LoweredProgram program = lowerAST(ast);
+    return writeLoweredIR(program, irFile);
+}
+
+void emitNativeProgramFromAST(const vector<ASTPtr>& ast, const string& outputFile, bool link) {
+    LoweredProgram program = lowerAST(ast);
+    emitLoweredNative(program, outputFile, link);
+}
@@ -18,6 +18,8 @@
 #include <set>
 #include <map>
 #include <unordered_map>
+#include <string_view>
+#include <cstdint>
 
 
 using namespace std;
@@ -547,6 +549,88 @@ struct TypeCheckError {
     }
 };
 
+// === Driver Types ===
+
+// Thrown by a phase once it has reported its diagnostics and compilation cannot continue.
+// The single-file driver turns it into an exit code; batch mode records it and moves on.
+struct CompilationError : runtime_error {
+    using runtime_error::runtime_error;
+};
+
+// TAC: source -> TAC text -> LLVM IR (the original pipeline). AST: the checked AST is lowered
+// straight to LLVM IR and TAC is only written on request. INTERP: the TAC text is executed by
+// an interpreter (interp.cpp) without LLVM, for programs that run shorter than a JIT compile.
+enum class Backend { TAC, AST, INTERP };
+
+// Value types of TAC variables and temporaries, shared by the TAC optimizer and both LLVM backends
+enum class VarType {
+    INT,
+    FLOAT,
+    DOUBLE,
+    CHAR,
+    STRING,
+    BOOL,
+    VOID,
+    UNKNOWN
+};
+
+struct CompilerOptions {
+    bool quiet = false;          // suppress per-phase success banners (batch mode)
+    bool timeReport = false;     // collect per-phase wall time, allocations and peak RSS
+    bool trace = false;          // record Chrome trace events for phases and per-function work
+    int optLevel = 0;            // -O0..-O3: LLVM pass pipeline run on the module before JIT/IR output
+    bool lazyJIT = true;         // compile functions on first call (ORC LLLazyJIT) instead of up front
+    string cacheDir;             // object cache for JIT runs; empty disables caching
+    Backend backend = Backend::TAC;
+    bool dumpTAC = false;        // with the AST backend, still write the TAC file for inspection
+    bool optimizeTAC = true;     // fold, propagate and clean up TAC before it is written (tacopt.cpp)
+};
+
+inline CompilerOptions compilerOptions;
+
+// Scoped Chrome trace-event span ("ph":"X"); costs one branch when tracing is off
+class TraceSpan {
+    const char* name;
+    string detail;
+    bool active;
+    long long startUs;
+    void begin(const string& spanDetail);
+    void end();
+public:
+    TraceSpan(const char* spanName, const string& spanDetail = "") : name(spanName), active(compilerOptions.trace), startUs(0) {
+        if (active) begin(spanDetail);
+    }
+    ~TraceSpan() {
+        if (active) end();
+    }
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+// Per-function spans compile away entirely with -DCOMPILER_NO_TRACING
+#ifdef COMPILER_NO_TRACING
+#define TRACE_SCOPE(name, detail) ((void)0)
+#else
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name, detail) TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(name, detail)
+#endif
+
+// Scoped phase measurement; a no-op unless compilerOptions.timeReport or .trace is set
+class PhaseTimer {
+    const char* name;
+    bool active;
+    long long startNs;
+    size_t startAllocations;
+    size_t startBytes;
+    TraceSpan span;
+public:
+    explicit PhaseTimer(const char* phaseName);
+    ~PhaseTimer();
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+};
+
 // ********************************* FUNCTION DECLARATIONS ******************************************
 
 vector<Token> lexAndDumpToFile(const string& inputFilename, const string& outputFilename);
@@ -556,6 +640,168 @@ vector<unique_ptr<ASTNode>> parseFromFile(const vector<Token>& tokens);
 void performScopeAnalysis(const vector<ASTPtr>& ast, const vector<Token>& tokens); 
 void performTypeChecking(const vector<ASTPtr>& ast, const vector<Token>& tokens);
 void generateTAC(const vector<unique_ptr<ASTNode>>& ast, const string& outputFilename);
-void executeTACProgram();
+// TAC optimizer (tacopt.cpp): constant folding, constant/copy propagation and dead code
+// elimination on generated TAC text; functions it cannot parse are passed through unchanged
+string optimizeTAC(const string& tac);
+// Quote-aware split of a TAC call's argument list ("a, ',', \"x, y\"" -> 3 arguments)
+vector<string> splitTACArguments(const string& argsStr);
+
+// TAC control flow graph (taccfg.cpp), shared by the TAC optimizer and TACExecutor.
+// How one statement affects control flow; the views point into the statement's text.
+struct TACControl {
+    enum Kind { NONE, LABEL, GOTO, BRANCH, SWITCH, RETURN };
+    Kind kind = NONE;
+    string_view label;            // LABEL: the label defined; GOTO, BRANCH: target; SWITCH: default
+    vector<string_view> cases;    // SWITCH: case targets
+};
+// Classifies one trimmed statement the way TACExecutor::processStatement dispatches it
+TACControl classifyTACStatement(string_view stmt);
+
+// A block starts at the first statement, at every label and after every jump or return
+struct TACBlock {
+    size_t begin = 0;             // statements [begin, end)
+    size_t end = 0;
+    vector<size_t> succs;
+    vector<size_t> preds;         // reachable predecessors only
+    size_t idom = SIZE_MAX;       // immediate dominator: the entry is its own, unreachable blocks have none
+    size_t domFirst = 0;          // dominator tree preorder number, and the last one in its subtree
+    size_t domLast = 0;
+    bool reachable = false;       // from the entry block
+};
+
+// Basic blocks of one function body, with edges and dominator tree. Label keys are views into
+// the statements, so the graph must not outlive them.
+struct TACControlFlowGraph {
+    vector<TACBlock> blocks;      // in statement order; blocks[0] is the entry
+    vector<size_t> blockOf;       // statement index -> block
+    unordered_map<string_view, size_t> blockByLabel;
+    vector<size_t> order;         // reachable blocks in reverse postorder
+
+    bool dominates(size_t a, size_t b) const;   // constant time
+    // Blocks of the natural loop closed by the back edge tail -> header, header first; costs
+    // time in the loop's size, not the function's
+    vector<size_t> naturalLoop(size_t header, size_t tail) const;
+    // Per block, the blocks where its dominance ends; the entry counts as entered once from outside
+    vector<vector<size_t>> dominanceFrontiers() const;
+};
+TACControlFlowGraph buildTACControlFlowGraph(const vector<TACControl>& statements);
+
+// Facts of a block-level dataflow problem at the start and at the end of every block
+template <typename Fact>
+struct TACDataflowResult {
+    vector<Fact> entry;
+    vector<Fact> exit;
+};
+
+// Worklist solver over the reachable blocks of a TAC control flow graph. A forward problem meets
+// the predecessors' exit facts into a block's entry fact and gets its exit fact from
+// transfer(block, entry); a backward problem meets the successors' entry facts into the exit
+// fact and gets the entry fact from transfer(block, exit). The function entry (forward) and
+// blocks without successors (backward) also meet `boundary`; facts not computed yet are
+// `initial`. meet(into, other) and transfer must be monotone for the solver to terminate.
+template <typename Fact, typename Transfer, typename Meet>
+TACDataflowResult<Fact> solveTACDataflow(const TACControlFlowGraph& cfg, bool forward, const Fact& boundary,
+                                         const Fact& initial, Transfer transfer, Meet meet) {
+    size_t count = cfg.blocks.size();
+    TACDataflowResult<Fact> result{vector<Fact>(count, initial), vector<Fact>(count, initial)};
+    vector<Fact>& before = forward ? result.entry : result.exit;
+    vector<Fact>& after = forward ? result.exit : result.entry;
+
+    // Popped from the back: reverse postorder for forward problems, postorder for backward ones
+    vector<size_t> worklist(cfg.order.rbegin(), cfg.order.rend());
+    if (!forward) worklist = cfg.order;
+    vector<bool> queued(count, false);
+    for (size_t block : worklist) queued[block] = true;
+
+    while (!worklist.empty()) {
+        size_t block = worklist.back();
+        worklist.pop_back();
+        queued[block] = false;
+
+        const vector<size_t>& sources = forward ? cfg.blocks[block].preds : cfg.blocks[block].succs;
+        bool atBoundary = forward ? block == 0 : sources.empty();
+        Fact fact = atBoundary || sources.empty() ? boundary : after[sources[0]];
+        for (size_t i = atBoundary ? 0 : 1; i < sources.size(); i++) meet(fact, after[sources[i]]);
+
+        Fact next = transfer(block, fact);
+        before[block] = std::move(fact);
+        if (next == after[block]) continue;
+        after[block] = std::move(next);
+        for (size_t target : forward ? cfg.blocks[block].succs : cfg.blocks[block].preds) {
+            if (queued[target]) continue;
+            queued[target] = true;
+            worklist.push_back(target);
+        }
+    }
+    return result;
+}
+
+// Which names one statement assigns and reads, for SSA construction
+struct TACDefUse {
+    string_view def;               // empty if the statement assigns nothing
+    vector<string_view> uses;      // operands; literals and names never assigned are left out of the form
+};
+
+// One SSA value: a name's value on entry, one assignment, or a merge where assignments meet
+struct TACSSAValue {
+    enum Kind { ENTRY, DEF, PHI };
+    Kind kind = ENTRY;
+    size_t variable = 0;           // index into TACSSAForm::variables
+    size_t at = 0;                 // DEF: statement; PHI: block
+    vector<size_t> operands;       // PHI: value per predecessor, in TACBlock::preds order; the
+                                   // entry block's phis take its ENTRY value as one more, last
+};
+
+// Pruned SSA form of a function's reachable blocks: phis are placed on iterated dominance
+// frontiers where the name is live. Statements are not rewritten; the form maps each def and
+// use to its value.
+struct TACSSAForm {
+    vector<string> variables;      // names assigned in reachable blocks
+    vector<TACSSAValue> values;
+    vector<vector<size_t>> phis;   // per block
+    vector<size_t> defOf;          // per statement: value assigned, SIZE_MAX if none
+    vector<size_t> uses;           // value read by every use, SIZE_MAX for other operands
+    vector<size_t> firstUse;       // per statement, and one past the last: where its uses start
+
+    size_t& useOf(size_t statement, size_t use) { return uses[firstUse[statement] + use]; }
+    size_t useOf(size_t statement, size_t use) const { return uses[firstUse[statement] + use]; }
+};
+TACSSAForm buildTACSSA(const TACControlFlowGraph& cfg, const vector<TACDefUse>& statements);
+
+// Wall-clock split of one JIT run, so generated-code speed can be measured apart from compile time
+struct RunStats {
+    double buildMs = 0;    // TAC or AST -> LLVM IR, including verification and optimization
+    double jitMs = 0;      // JIT setup; with an eager JIT also all machine code generation
+    double executeMs = 0;  // the program itself
+    int exitCode = 0;      // value returned by the program's main
+};
+// With a cache key (and compilerOptions.cacheDir set) the compiled object is stored in the cache
+RunStats executeTACProgram(const string& tacFile = "tester/tac.txt", const string& cacheKey = "");
+
+// TAC interpreter (interp.cpp): runs tester/tac.txt directly; buildMs is the translation to
+// interpreter code, jitMs stays 0. Throws CompilationError on a runtime error.
+RunStats interpretTACProgram(const string& tacFile = "tester/tac.txt");
+
+// Compilation cache: the key hashes the source plus codegen-relevant flags; runCachedProgram
+// JIT-loads <cacheDir>/<key>.o and runs it, returning false on a cache miss
+string compilationCacheKey(const string& sourceFile);
+bool runCachedProgram(const string& cacheKey, RunStats& stats);
+size_t compileTACToIR(const string& tacFile, const string& irFile);  // returns LLVM instruction count
+void emitNativeProgram(const string& tacFile, const string& outputFile, bool link);
+
+// AST backend (codegen.cpp): same contracts as the TAC entry points above
+RunStats executeASTProgram(const vector<ASTPtr>& ast, const string& cacheKey = "");
+size_t compileASTToIR(const vector<ASTPtr>& ast, const string& irFile);
+void emitNativeProgramFromAST(const vector<ASTPtr>& ast, const string& outputFile, bool link);
+
+// Time report collected by PhaseTimer
+void printTimeReport(ostream& out);
+bool writeTimeReportJSON(const string& filename);
+
+// Trace events collected by TraceSpan, written in Chrome/Perfetto JSON format
+bool writeTraceJSON(const string& filename);
+
+// Batch mode: compiles every input (files, directories, wildcards or @listfiles) on a worker pool
+int runBatchCompilation(const vector<string>& inputs, const string& outputDir, unsigned jobs);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,1044 @@
+#include "backend.h"
+
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <fstream>
+
+// === TAC Interpreter ===
+// Runs the TAC text directly, without building an LLVM module or a JIT, so short programs
+// start executing as soon as the TAC is written. Each function is translated once into
+// instructions over a register file: every named variable and every temporary definition gets
+// a register of its frame, and literals live in constant registers at the bottom of the frame
+// that are copied in on every call. Operations are typed (32-bit int, char, float, double,
+// string pointer) with the same types and conversions TACExecutor gives the LLVM values, so
+// a program prints what the JIT-compiled one prints.
+//
+// A call pushes a frame onto one register stack and returns through an explicit frame list,
+// so the dispatch loop never recurses. Dispatch uses computed goto where the compiler supports
+// it and a switch otherwise.
+
+namespace {
+
+// LLVM type of a TAC value as TACExecutor lowers it: bool is an int, char an i8
+enum class Kind : uint8_t { I32, I8, F32, F64, PTR, VOID };
+
+Kind kindOf(VarType type) {
+    switch (type) {
+        case VarType::CHAR: return Kind::I8;
+        case VarType::FLOAT: return Kind::F32;
+        case VarType::DOUBLE: return Kind::F64;
+        case VarType::STRING: return Kind::PTR;
+        case VarType::VOID: return Kind::VOID;
+        default: return Kind::I32;
+    }
+}
+
+bool isInteger(Kind kind) { return kind == Kind::I32 || kind == Kind::I8; }
+bool isFloating(Kind kind) { return kind == Kind::F32 || kind == Kind::F64; }
+
+// One register. Chars are kept sign-extended in `i`, as an i8 converts to a wider type.
+union Slot {
+    int32_t i;
+    float f;
+    double d;
+    const char* s;
+};
+
+Slot zeroSlot() {
+    Slot slot;
+    slot.s = nullptr;
+    return slot;
+}
+
+// fptosi; out of range and NaN give INT_MIN like the host's cvttsd2si
+int32_t toInt32(double value) {
+    if (!(value > -2147483649.0 && value < 2147483648.0)) return INT32_MIN;
+    return static_cast<int32_t>(value);
+}
+
+// Register operands are marked in the mask (1: a, 2: b, 4: c). Value-producing operations
+// write a; jumps keep their target in a.
+#define INTERP_OPS(X) \
+    X(MOVE, 3) \
+    X(I32_TO_I8, 3) X(I8_TO_I32, 3) X(I32_TO_F32, 3) X(I32_TO_F64, 3) \
+    X(F32_TO_F64, 3) X(F64_TO_F32, 3) X(F32_TO_I32, 3) X(F64_TO_I32, 3) \
+    X(ADD_I32, 7) X(SUB_I32, 7) X(MUL_I32, 7) X(DIV_I32, 7) X(MOD_I32, 7) \
+    X(AND_I32, 7) X(OR_I32, 7) X(XOR_I32, 7) X(SHL_I32, 7) X(SHR_I32, 7) X(NEG_I32, 3) X(NOT_I32, 3) \
+    X(ADD_F32, 7) X(SUB_F32, 7) X(MUL_F32, 7) X(DIV_F32, 7) X(NEG_F32, 3) \
+    X(ADD_F64, 7) X(SUB_F64, 7) X(MUL_F64, 7) X(DIV_F64, 7) X(NEG_F64, 3) \
+    X(EQ_I32, 7) X(NE_I32, 7) X(LT_I32, 7) X(GT_I32, 7) X(LE_I32, 7) X(GE_I32, 7) \
+    X(EQ_F32, 7) X(NE_F32, 7) X(LT_F32, 7) X(GT_F32, 7) X(LE_F32, 7) X(GE_F32, 7) \
+    X(EQ_F64, 7) X(NE_F64, 7) X(LT_F64, 7) X(GT_F64, 7) X(LE_F64, 7) X(GE_F64, 7) \
+    X(EQ_PTR, 7) X(NE_PTR, 7) X(LT_PTR, 7) X(GT_PTR, 7) X(LE_PTR, 7) X(GE_PTR, 7) \
+    X(JMP, 0) X(JZ, 2) X(JNZ, 2) \
+    X(BEQ, 6) X(BNE, 6) X(BLT, 6) X(BGT, 6) X(BLE, 6) X(BGE, 6) \
+    X(SWITCH, 1) X(CALL, 1) X(RET, 1) \
+    X(PRINT_I32, 1) X(PRINT_CHAR, 1) X(PRINT_F32, 1) X(PRINT_F64, 1) X(PRINT_STR, 1) X(PRINT_TEXT, 0)
+
+enum class Op : uint8_t {
+#define INTERP_OP_ENUM(name, regs) name,
+    INTERP_OPS(INTERP_OP_ENUM)
+#undef INTERP_OP_ENUM
+};
+
+const uint8_t registerOperands[] = {
+#define INTERP_OP_REGS(name, regs) regs,
+    INTERP_OPS(INTERP_OP_REGS)
+#undef INTERP_OP_REGS
+};
+
+// CALL: a = destination register or -1, b = function, c = argument list (count, registers...)
+// RET: a = value register or -1 for the zero of the return type
+// SWITCH: a = operand, b = table. PRINT_TEXT: a = text.
+struct Instr {
+    Op op;
+    int32_t a, b, c;
+};
+
+struct SwitchTable {
+    int32_t low = 0;
+    vector<int32_t> dense;                  // target per value from `low`, when the values are dense
+    vector<pair<int32_t, int32_t>> sparse;  // sorted (value, target) otherwise
+    int32_t defaultTarget = 0;
+};
+
+struct InterpFunction {
+    string name;
+    Kind returnKind = Kind::I32;
+    vector<Kind> paramKinds;
+    vector<int32_t> paramRegisters;
+    vector<Instr> code;
+    vector<Slot> constants;                 // registers [0, constants.size())
+    int32_t frameSize = 0;
+};
+
+struct Operand {
+    int32_t reg = -1;
+    Kind kind = Kind::I32;
+    bool constant = false;
+    Slot value = zeroSlot();                // when constant
+};
+
+string trimmed(const string& s) {
+    size_t start = s.find_first_not_of(" \t");
+    if (start == string::npos) return "";
+    return s.substr(start, s.find_last_not_of(" \t") - start + 1);
+}
+
+bool isFunctionBegin(const string& line) {
+    return line.find("function ") != string::npos && line.find(" begin") != string::npos;
+}
+
+bool isFunctionEnd(const string& line) {
+    return line.find("function ") != string::npos && line.find(" end") != string::npos;
+}
+
+string functionName(const string& line) {
+    size_t start = line.find("function ") + 9;
+    return line.substr(start, line.find(' ', start) - start);
+}
+
+VarType parseType(const string& typeStr) {
+    if (typeStr == "int") return VarType::INT;
+    if (typeStr == "float") return VarType::FLOAT;
+    if (typeStr == "double") return VarType::DOUBLE;
+    if (typeStr == "char") return VarType::CHAR;
+    if (typeStr == "string") return VarType::STRING;
+    if (typeStr == "bool") return VarType::BOOL;
+    if (typeStr == "void") return VarType::VOID;
+    return VarType::UNKNOWN;
+}
+
+struct RuntimeError : runtime_error {
+    using runtime_error::runtime_error;
+};
+
+// Registers of all active frames; a frame starts right after its caller's
+constexpr size_t kStackSlots = size_t(1) << 22;
+
+struct CallFrame {
+    const InterpFunction* function;
+    const Instr* returnAddress;
+    Slot* registers;
+    int32_t destination;
+};
+
+class TACInterpreter {
+private:
+    vector<string> tacLines;
+    vector<InterpFunction> functions;
+    unordered_map<string, int32_t> functionIndex;
+    vector<int32_t> argumentLists;
+    vector<SwitchTable> switchTables;
+    deque<string> strings;                  // string constants and print text; addresses stay put
+    unordered_map<string, const char*> internedStrings;
+
+    // Translation state of the current function. Registers are numbered from 0 while it is
+    // translated and constants from kConstantBase; finishFunction moves the constants to the
+    // bottom of the frame.
+    static constexpr int32_t kConstantBase = 1 << 30;
+    InterpFunction* function = nullptr;
+    int32_t registerCount = 0;
+    map<pair<Kind, uint64_t>, int32_t> constantRegisters;
+    unordered_map<string, Operand> namedValues;
+    unordered_map<string, Operand> tempValues;
+    vector<bool> variableRegisters;         // registers that belong to a named variable
+    unordered_map<string, int32_t> labelIds;
+    vector<int32_t> labelTargets;
+    vector<vector<pair<int32_t, int32_t>>> switchCases;   // per table of this function: (value, label id)
+    vector<pair<int32_t, int32_t>> switchDefaults;         // (table, label id)
+    size_t firstArgumentList = 0;
+    size_t firstSwitchTable = 0;
+    int32_t freshResult = -1;               // register written by the last instruction, if it is new
+
+public:
+    bool readTACFile(const string& filename) {
+        ifstream file(filename);
+        if (!file.is_open()) {
+            cerr << "Error: Cannot open TAC file: " << filename << endl;
+            return false;
+        }
+        string line;
+        while (getline(file, line)) {
+            line = trimmed(line);
+            if (!line.empty()) tacLines.push_back(line);
+        }
+        return true;
+    }
+
+    void translate() {
+        PhaseTimer timer("interp-build");
+        declareFunctions();
+        size_t line = 0;
+        while (line < tacLines.size()) {
+            if (isFunctionBegin(tacLines[line])) line = translateFunction(line);
+            else line++;
+        }
+    }
+
+    bool hasMain() const { return functionIndex.count("main") > 0; }
+    bool mainReturnsVoid() const { return functions[functionIndex.at("main")].returnKind == Kind::VOID; }
+
+    int32_t run();
+
+private:
+    // === Translation ===
+
+    // Signatures first, so a call can precede the callee's body: [type] function name begin,
+    // followed by one `type name = param` line per parameter
+    void declareFunctions() {
+        for (size_t i = 0; i < tacLines.size(); i++) {
+            const string& line = tacLines[i];
+            if (!isFunctionBegin(line)) continue;
+
+            InterpFunction declared;
+            declared.name = functionName(line);
+            string returnType = trimmed(line.substr(0, line.find("function ")));
+            declared.returnKind = returnType.empty() ? Kind::I32 : kindOf(parseType(returnType));
+            for (size_t j = i + 1; j < tacLines.size() && tacLines[j].find(" = param") != string::npos; j++) {
+                istringstream iss(tacLines[j].substr(0, tacLines[j].find(" = param")));
+                string typeStr;
+                iss >> typeStr;
+                declared.paramKinds.push_back(kindOf(parseType(typeStr)));
+            }
+
+            auto [it, inserted] = functionIndex.emplace(declared.name, static_cast<int32_t>(functions.size()));
+            if (inserted) functions.push_back(std::move(declared));
+            else functions[it->second] = std::move(declared);
+        }
+    }
+
+    size_t translateFunction(size_t line) {
+        string name = functionName(tacLines[line]);
+        TRACE_SCOPE("translateFunction", name);
+        function = &functions[functionIndex[name]];
+        function->code.clear();
+        function->constants.clear();
+        function->paramRegisters.clear();
+        registerCount = 0;
+        constantRegisters.clear();
+        namedValues.clear();
+        tempValues.clear();
+        variableRegisters.clear();
+        labelIds.clear();
+        labelTargets.clear();
+        switchCases.clear();
+        switchDefaults.clear();
+        firstArgumentList = argumentLists.size();
+        firstSwitchTable = switchTables.size();
+        freshResult = -1;
+        line++;
+
+        // Parameters are the first registers, in signature order
+        size_t paramIndex = 0;
+        while (line < tacLines.size() && tacLines[line].find(" = param") != string::npos) {
+            istringstream iss(tacLines[line].substr(0, tacLines[line].find(" = param")));
+            string typeStr, paramName;
+            iss >> typeStr >> paramName;
+            if (paramIndex < function->paramKinds.size()) {
+                Operand param = newVariable(paramName, function->paramKinds[paramIndex++]);
+                function->paramRegisters.push_back(param.reg);
+            }
+            line++;
+        }
+
+        // Labels are known up front; a jump to a label the function does not define is
+        // ignored, as in TACExecutor
+        size_t bodyEnd = line;
+        while (bodyEnd < tacLines.size() && !isFunctionEnd(tacLines[bodyEnd])) {
+            const string& stmt = tacLines[bodyEnd];
+            if (stmt.back() == ':' && stmt.find("//") != 0) {
+                labelIds.emplace(stmt.substr(0, stmt.size() - 1), static_cast<int32_t>(labelIds.size()));
+            }
+            bodyEnd++;
+        }
+        labelTargets.assign(labelIds.size(), 0);
+
+        for (; line < bodyEnd; line++) translateStatement(tacLines[line]);
+        emit(Op::RET, -1);
+
+        finishFunction();
+        return bodyEnd + 1;
+    }
+
+    // Resolves labels and moves the constant registers below the variables
+    void finishFunction() {
+        int32_t constantCount = static_cast<int32_t>(function->constants.size());
+        auto relocate = [&](int32_t& reg) {
+            if (reg < 0) return;
+            reg = reg >= kConstantBase ? reg - kConstantBase : reg + constantCount;
+        };
+        for (Instr& instr : function->code) {
+            uint8_t regs = registerOperands[static_cast<size_t>(instr.op)];
+            if (regs & 1) relocate(instr.a);
+            if (regs & 2) relocate(instr.b);
+            if (regs & 4) relocate(instr.c);
+            switch (instr.op) {
+                case Op::JMP: case Op::JZ: case Op::JNZ:
+                case Op::BEQ: case Op::BNE: case Op::BLT: case Op::BGT: case Op::BLE: case Op::BGE:
+                    instr.a = labelTargets[instr.a];
+                    break;
+                default:
+                    break;
+            }
+        }
+        for (size_t i = firstArgumentList; i < argumentLists.size(); ) {
+            int32_t count = argumentLists[i++];
+            for (int32_t k = 0; k < count; k++) relocate(argumentLists[i++]);
+        }
+        for (int32_t& reg : function->paramRegisters) relocate(reg);
+
+        for (size_t t = 0; t < switchCases.size(); t++) {
+            SwitchTable& table = switchTables[firstSwitchTable + t];
+            vector<pair<int32_t, int32_t>> cases;
+            for (const auto& [value, label] : switchCases[t]) cases.push_back({value, labelTargets[label]});
+            sort(cases.begin(), cases.end());
+            cases.erase(unique(cases.begin(), cases.end(),
+                               [](const auto& x, const auto& y) { return x.first == y.first; }), cases.end());
+            if (!cases.empty() && static_cast<int64_t>(cases.back().first) - cases.front().first < 4 * static_cast<int64_t>(cases.size()) + 8) {
+                table.low = cases.front().first;
+                table.dense.assign(cases.back().first - table.low + 1, -1);
+                for (const auto& [value, target] : cases) table.dense[value - table.low] = target;
+            } else {
+                table.sparse = std::move(cases);
+            }
+        }
+        for (const auto& [table, label] : switchDefaults) {
+            switchTables[firstSwitchTable + table].defaultTarget = labelTargets[label];
+        }
+
+        function->frameSize = constantCount + registerCount;
+    }
+
+    void emit(Op op, int32_t a, int32_t b = 0, int32_t c = 0) {
+        function->code.push_back({op, a, b, c});
+        freshResult = -1;
+    }
+
+    Operand newVariable(const string& name, Kind kind) {
+        Operand variable{registerCount++, kind};
+        variableRegisters.resize(registerCount);
+        variableRegisters[variable.reg] = true;
+        namedValues[name] = variable;
+        return variable;
+    }
+    
+    // An operation writing a new register of the given kind
+    Operand emitValue(Op op, Kind kind, int32_t b, int32_t c = 0) {
+        Operand result{registerCount++, kind};
+        emit(op, result.reg, b, c);
+        freshResult = result.reg;
+        return result;
+    }
+
+    Operand constant(Kind kind, Slot value) {
+        uint64_t bits = 0;
+        switch (kind) {
+            case Kind::F32: memcpy(&bits, &value.f, sizeof(value.f)); break;
+            case Kind::F64: memcpy(&bits, &value.d, sizeof(value.d)); break;
+            case Kind::PTR: bits = reinterpret_cast<uintptr_t>(value.s); break;
+            default: bits = static_cast<uint32_t>(value.i); break;
+        }
+        auto [it, inserted] = constantRegisters.emplace(make_pair(kind, bits), 0);
+        if (inserted) {
+            it->second = kConstantBase + static_cast<int32_t>(function->constants.size());
+            function->constants.push_back(value);
+        }
+        Operand result{it->second, kind, true, value};
+        return result;
+    }
+
+    Operand intConstant(int32_t value) {
+        Slot slot = zeroSlot();
+        slot.i = value;
+        return constant(Kind::I32, slot);
+    }
+
+    const char* intern(const string& text) {
+        auto it = internedStrings.find(text);
+        if (it != internedStrings.end()) return it->second;
+        strings.push_back(text);
+        const char* stored = strings.back().c_str();
+        internedStrings.emplace(text, stored);
+        return stored;
+    }
+
+    int32_t labelOf(const string& name) const {
+        auto it = labelIds.find(name);
+        return it == labelIds.end() ? -1 : it->second;
+    }
+
+    // Literals, temporaries and variables, resolved like TACExecutor::getValueWithType;
+    // anything else is the int 0
+    Operand valueOf(const string& name) {
+        Slot slot = zeroSlot();
+        if (name.size() >= 2 && name[0] == '"' && name.back() == '"') {
+            slot.s = intern(name.substr(1, name.size() - 2));
+            return constant(Kind::PTR, slot);
+        }
+        if (name.size() >= 2 && name[0] == '\'' && name.back() == '\'') {
+            slot.i = name.size() == 3 ? static_cast<signed char>(name[1]) : 0;
+            return constant(Kind::I8, slot);
+        }
+        if (name == "true") return intConstant(1);
+        if (name == "false") return intConstant(0);
+
+        auto temp = tempValues.find(name);
+        if (temp != tempValues.end()) return temp->second;
+        auto named = namedValues.find(name);
+        if (named != namedValues.end()) return named->second;
+
+        if (name.find('.') != string::npos || name.find('e') != string::npos || name.find('E') != string::npos) {
+            bool isFloat = name.back() == 'f' || name.back() == 'F';
+            string digits = isFloat ? name.substr(0, name.size() - 1) : name;
+            char* end = nullptr;
+            double value = strtod(digits.c_str(), &end);
+            if (end && *end == '\0' && !digits.empty()) {
+                if (isFloat) {
+                    slot.f = static_cast<float>(value);
+                    return constant(Kind::F32, slot);
+                }
+                slot.d = value;
+                return constant(Kind::F64, slot);
+            }
+            return intConstant(0);
+        }
+        if (!name.empty() && (name[0] == '-' || isdigit(static_cast<unsigned char>(name[0]))) &&
+            name.find_first_not_of("-0123456789") == string::npos) {
+            return intConstant(static_cast<int32_t>(strtoll(name.c_str(), nullptr, 10)));
+        }
+        return intConstant(0);
+    }
+
+    // Conversion to another kind; constants are converted right away
+    Operand convert(const Operand& value, Kind to) {
+        Kind from = value.kind;
+        if (from == to || from == Kind::PTR || to == Kind::PTR || to == Kind::VOID) return value;
+
+        if (value.constant) {
+            Slot slot = zeroSlot();
+            double number = from == Kind::F32 ? value.value.f : from == Kind::F64 ? value.value.d : value.value.i;
+            switch (to) {
+                case Kind::I32: slot.i = isFloating(from) ? toInt32(number) : value.value.i & (from == Kind::I8 ? 0xFF : ~0); break;
+                case Kind::I8: slot.i = static_cast<signed char>(isFloating(from) ? toInt32(number) : value.value.i); break;
+                case Kind::F32: slot.f = static_cast<float>(number); break;
+                case Kind::F64: slot.d = number; break;
+                default: break;
+            }
+            return constant(to, slot);
+        }
+
+        Operand current = value;
+        if (isFloating(from) && isInteger(to)) {
+            current = emitValue(from == Kind::F32 ? Op::F32_TO_I32 : Op::F64_TO_I32, Kind::I32, current.reg);
+            return to == Kind::I8 ? emitValue(Op::I32_TO_I8, Kind::I8, current.reg) : current;
+        }
+        if (isInteger(from) && isFloating(to)) {
+            return emitValue(to == Kind::F32 ? Op::I32_TO_F32 : Op::I32_TO_F64, to, current.reg);
+        }
+        if (isFloating(from)) {
+            return emitValue(to == Kind::F64 ? Op::F32_TO_F64 : Op::F64_TO_F32, to, current.reg);
+        }
+        return emitValue(to == Kind::I8 ? Op::I32_TO_I8 : Op::I8_TO_I32, to, current.reg);
+    }
+
+    // A char compared with or combined with an int is zero-extended first
+    void widenChars(Operand& left, Operand& right) {
+        if (left.kind == Kind::I8 && right.kind == Kind::I32) left = convert(left, Kind::I32);
+        if (right.kind == Kind::I8 && left.kind == Kind::I32) right = convert(right, Kind::I32);
+    }
+
+    // Brings both operands of a comparison to a common kind: floating point if either side is,
+    // otherwise ints (a char next to an int zero-extended)
+    Kind comparisonKind(Operand& left, Operand& right) {
+        if (isFloating(left.kind) || isFloating(right.kind)) {
+            Kind kind = left.kind == Kind::F64 || right.kind == Kind::F64 ? Kind::F64 : Kind::F32;
+            left = convert(left, kind);
+            right = convert(right, kind);
+            return kind;
+        }
+        if (left.kind == Kind::PTR && right.kind == Kind::PTR) return Kind::PTR;
+        widenChars(left, right);
+        return Kind::I32;
+    }
+
+    static Op comparisonOp(const string& op, Kind kind) {
+        static const char* const names[] = {"==", "!=", "<", ">", "<=", ">="};
+        size_t index = find(begin(names), end(names), op) - begin(names);
+        int base = kind == Kind::F32 ? static_cast<int>(Op::EQ_F32)
+                 : kind == Kind::F64 ? static_cast<int>(Op::EQ_F64)
+                 : kind == Kind::PTR ? static_cast<int>(Op::EQ_PTR)
+                 : static_cast<int>(Op::EQ_I32);
+        return static_cast<Op>(base + index);
+    }
+
+    Operand translateBinary(const string& expr) {
+        static const pair<const char*, const char*> ops[] = {
+            {" << ", "<<"}, {" >> ", ">>"},
+            {" == ", "=="}, {" != ", "!="}, {" <= ", "<="}, {" >= ", ">="},
+            {" < ", "<"}, {" > ", ">"},
+            {" && ", "&"}, {" || ", "|"},
+            {" & ", "&"}, {" | ", "|"}, {" ^ ", "^"},
+            {" + ", "+"}, {" - ", "-"}, {" * ", "*"}, {" / ", "/"}, {" % ", "%"}
+        };
+        for (const auto& [pattern, op] : ops) {
+            size_t pos = expr.find(pattern);
+            if (pos == string::npos) continue;
+            Operand left = valueOf(trimmed(expr.substr(0, pos)));
+            Operand right = valueOf(trimmed(expr.substr(pos + strlen(pattern))));
+            string name = op;
+
+            if (name == "==" || name == "!=" || name == "<" || name == ">" || name == "<=" || name == ">=") {
+                Kind kind = comparisonKind(left, right);
+                return emitValue(comparisonOp(name, kind), Kind::I32, left.reg, right.reg);
+            }
+
+            // Floating point if either side is; bitwise operators, shifts and % work on ints
+            bool integerOnly = name == "&" || name == "|" || name == "^" || name == "<<" || name == ">>" || name == "%";
+            Kind kind = Kind::I32;
+            if (!integerOnly && (left.kind == Kind::F64 || right.kind == Kind::F64)) kind = Kind::F64;
+            else if (!integerOnly && (left.kind == Kind::F32 || right.kind == Kind::F32)) kind = Kind::F32;
+
+            if (isFloating(kind)) {
+                left = convert(left, kind);
+                right = convert(right, kind);
+                int base = static_cast<int>(kind == Kind::F32 ? Op::ADD_F32 : Op::ADD_F64);
+                int offset = name == "+" ? 0 : name == "-" ? 1 : name == "*" ? 2 : 3;
+                return emitValue(static_cast<Op>(base + offset), kind, left.reg, right.reg);
+            }
+
+            // Two chars stay a char; otherwise a char operand is zero-extended
+            if (isFloating(left.kind)) left = convert(left, Kind::I32);
+            if (isFloating(right.kind)) right = convert(right, Kind::I32);
+            bool charResult = left.kind == Kind::I8 && right.kind == Kind::I8;
+            widenChars(left, right);
+            Op intOp = name == "+" ? Op::ADD_I32 : name == "-" ? Op::SUB_I32 : name == "*" ? Op::MUL_I32
+                     : name == "/" ? Op::DIV_I32 : name == "%" ? Op::MOD_I32 : name == "&" ? Op::AND_I32
+                     : name == "|" ? Op::OR_I32 : name == "^" ? Op::XOR_I32 : name == "<<" ? Op::SHL_I32 : Op::SHR_I32;
+            Operand result = emitValue(intOp, Kind::I32, left.reg, right.reg);
+            return charResult ? emitValue(Op::I32_TO_I8, Kind::I8, result.reg) : result;
+        }
+        return intConstant(0);
+    }
+
+    // -x keeps the operand's kind; !x is a bitwise not
+    Operand translateUnary(const string& expr) {
+        Operand operand = valueOf(trimmed(expr.substr(1)));
+        if (expr[0] == '-') {
+            if (operand.kind == Kind::F32) return emitValue(Op::NEG_F32, Kind::F32, operand.reg);
+            if (operand.kind == Kind::F64) return emitValue(Op::NEG_F64, Kind::F64, operand.reg);
+            Operand result = emitValue(Op::NEG_I32, Kind::I32, operand.reg);
+            return operand.kind == Kind::I8 ? emitValue(Op::I32_TO_I8, Kind::I8, result.reg) : result;
+        }
+        if (isFloating(operand.kind)) operand = convert(operand, Kind::I32);
+        Operand result = emitValue(Op::NOT_I32, Kind::I32, operand.reg);
+        result.kind = operand.kind == Kind::I8 ? Kind::I8 : Kind::I32;
+        return result;
+    }
+
+    void translateStatement(const string& stmt) {
+        freshResult = -1;
+        if (stmt.empty() || stmt.find("//") == 0) return;
+        if (stmt.back() == ':') {
+            int32_t label = labelOf(stmt.substr(0, stmt.size() - 1));
+            if (label >= 0) labelTargets[label] = static_cast<int32_t>(function->code.size());
+            return;
+        }
+        if (stmt.find("call ") == 0) translateCall(stmt, nullptr);
+        else if (stmt.find("switch ") == 0) translateSwitch(stmt);
+        else if (stmt.find(" = ") != string::npos) translateAssignment(stmt);
+        else if ((stmt.find("if ") == 0 || stmt.find("ifFalse ") == 0) && stmt.find(" goto ") != string::npos) translateBranch(stmt);
+        else if (stmt.find("goto ") == 0) translateGoto(stmt);
+        else if (stmt.find("return") == 0) translateReturn(stmt);
+    }
+
+    void translateAssignment(const string& stmt) {
+        size_t eqPos = stmt.find(" = ");
+        string lhs = trimmed(stmt.substr(0, eqPos));
+        string rhs = trimmed(stmt.substr(eqPos + 3));
+        if (rhs == "param" || rhs.empty() || lhs.empty()) return;
+
+        // [type] name
+        istringstream iss(lhs);
+        string first, second;
+        iss >> first >> second;
+        string varName = second.empty() ? first : second;
+        VarType declaredType = second.empty() ? VarType::UNKNOWN : parseType(first);
+
+        Operand result;
+        if (rhs.find("call ") == 0) {
+            result = translateCall(rhs, &result) ? result : intConstant(0);
+        } else if (rhs.find(" + ") != string::npos || rhs.find(" - ") != string::npos ||
+                   rhs.find(" * ") != string::npos || rhs.find(" / ") != string::npos ||
+                   rhs.find(" % ") != string::npos || rhs.find(" == ") != string::npos ||
+                   rhs.find(" != ") != string::npos || rhs.find(" < ") != string::npos ||
+                   rhs.find(" > ") != string::npos || rhs.find(" <= ") != string::npos ||
+                   rhs.find(" >= ") != string::npos || rhs.find(" && ") != string::npos ||
+                   rhs.find(" || ") != string::npos || rhs.find(" & ") != string::npos ||
+                   rhs.find(" | ") != string::npos || rhs.find(" ^ ") != string::npos ||
+                   rhs.find(" << ") != string::npos || rhs.find(" >> ") != string::npos) {
+            result = translateBinary(rhs);
+        } else if ((rhs[0] == '-' || rhs[0] == '!') && rhs.size() > 1 && !isdigit(static_cast<unsigned char>(rhs[1]))) {
+            result = translateUnary(rhs);
+        } else {
+            result = valueOf(rhs);
+        }
+
+        if (declaredType != VarType::UNKNOWN) result = convert(result, kindOf(declaredType));
+
+        // A temporary names the value itself; a copy of a variable is taken now, since the
+        // variable's register may change before the temporary is read
+        bool isTemp = varName[0] == 't' && declaredType == VarType::UNKNOWN && !namedValues.count(varName);
+        if (isTemp) {
+            if (!result.constant && result.reg < static_cast<int32_t>(variableRegisters.size()) && variableRegisters[result.reg]) {
+                result = emitValue(Op::MOVE, result.kind, result.reg);
+            }
+            tempValues[varName] = result;
+            return;
+        }
+
+        auto named = namedValues.find(varName);
+        Operand target = named != namedValues.end() ? named->second : newVariable(varName, result.kind);
+        result = convert(result, target.kind);
+        if (result.reg == target.reg) return;
+        if (!result.constant && result.reg == freshResult) {
+            // The value was computed for this store: write it to the variable directly
+            function->code.back().a = target.reg;
+            freshResult = -1;
+            return;
+        }
+        emit(Op::MOVE, target.reg, result.reg);
+    }
+
+    // `call name(args)`; print is lowered to typed print operations. Returns whether a value
+    // was produced (into *result), which only a call of a known, non-void function does.
+    bool translateCall(const string& stmt, Operand* result) {
+        string rest = stmt.substr(stmt.find("call ") + 5);
+        size_t parenPos = rest.find('(');
+        size_t endParen = rest.rfind(')');
+        if (parenPos == string::npos || endParen == string::npos || endParen < parenPos) return false;
+        string funcName = rest.substr(0, parenPos);
+        vector<string> args = splitTACArguments(rest.substr(parenPos + 1, endParen - parenPos - 1));
+
+        if (funcName == "print") {
+            translatePrint(args);
+            return false;
+        }
+
+        auto callee = functionIndex.find(funcName);
+        if (callee == functionIndex.end()) return false;
+        const InterpFunction& info = functions[callee->second];
+
+        vector<int32_t> registers;
+        for (size_t i = 0; i < args.size(); i++) {
+            Operand value = valueOf(args[i]);
+            if (i < info.paramKinds.size()) value = convert(value, info.paramKinds[i]);
+            registers.push_back(value.reg);
+        }
+        int32_t list = static_cast<int32_t>(argumentLists.size());
+        argumentLists.push_back(static_cast<int32_t>(min(registers.size(), info.paramKinds.size())));
+        argumentLists.insert(argumentLists.end(), registers.begin(), registers.begin() + argumentLists[list]);
+
+        if (result && info.returnKind != Kind::VOID) {
+            *result = emitValue(Op::CALL, info.returnKind, callee->second, list);
+            return true;
+        }
+        emit(Op::CALL, -1, callee->second, list);
+        return false;
+    }
+
+    // Literal text and int or char constants are printed as one piece of text
+    void translatePrint(const vector<string>& args) {
+        string text;
+        auto flushText = [&]() {
+            if (text.empty()) return;
+            emit(Op::PRINT_TEXT, 0);
+            function->code.back().a = static_cast<int32_t>(strings.size());
+            strings.push_back(text);
+            text.clear();
+        };
+        for (const string& arg : args) {
+            if (arg.size() >= 2 && arg[0] == '"' && arg.back() == '"') {
+                text += processEscapes(arg.substr(1, arg.size() - 2));
+                continue;
+            }
+            if (arg.size() >= 3 && arg[0] == '\'' && arg.back() == '\'') {
+                text += arg[1];
+                continue;
+            }
+            Operand value = valueOf(arg);
+            if (value.constant && value.kind == Kind::I32) {
+                text += to_string(value.value.i);
+                continue;
+            }
+            if (value.constant && value.kind == Kind::I8) {
+                text += static_cast<char>(value.value.i);
+                continue;
+            }
+            flushText();
+            Op op = value.kind == Kind::PTR ? Op::PRINT_STR
+                  : value.kind == Kind::F32 ? Op::PRINT_F32
+                  : value.kind == Kind::F64 ? Op::PRINT_F64
+                  : value.kind == Kind::I8 ? Op::PRINT_CHAR : Op::PRINT_I32;
+            emit(op, value.reg);
+        }
+        flushText();
+    }
+
+    // if a < b goto L jumps when the comparison holds, ifFalse when it does not; int
+    // comparisons branch directly, the others set a register that is tested
+    void translateBranch(const string& stmt) {
+        static const char* const comparisons[] = {" == ", " != ", " <= ", " >= ", " < ", " > "};
+        bool jumpIfFalse = stmt.find("ifFalse ") == 0;
+        size_t condStart = jumpIfFalse ? 8 : 3;
+        size_t gotoPos = stmt.find(" goto ");
+        string condition = trimmed(stmt.substr(condStart, gotoPos - condStart));
+        int32_t label = labelOf(trimmed(stmt.substr(gotoPos + 6)));
+        if (label < 0) return;
+
+        for (const char* pattern : comparisons) {
+            size_t pos = condition.find(pattern);
+            if (pos == string::npos) continue;
+            Operand left = valueOf(trimmed(condition.substr(0, pos)));
+            Operand right = valueOf(trimmed(condition.substr(pos + strlen(pattern))));
+            string op = trimmed(pattern);
+            Kind kind = comparisonKind(left, right);
+            if (kind == Kind::I32) {
+                static const char* const names[] = {"==", "!=", "<", ">", "<=", ">="};
+                static const Op branches[] = {Op::BEQ, Op::BNE, Op::BLT, Op::BGT, Op::BLE, Op::BGE};
+                static const Op inverted[] = {Op::BNE, Op::BEQ, Op::BGE, Op::BLE, Op::BGT, Op::BLT};
+                size_t index = find(begin(names), end(names), op) - begin(names);
+                emit(jumpIfFalse ? inverted[index] : branches[index], label, left.reg, right.reg);
+                return;
+            }
+            Operand test = emitValue(comparisonOp(op, kind), Kind::I32, left.reg, right.reg);
+            emit(jumpIfFalse ? Op::JZ : Op::JNZ, label, test.reg);
+            return;
+        }
+        Operand value = valueOf(condition);
+        if (isFloating(value.kind)) value = convert(value, Kind::I32);
+        emit(jumpIfFalse ? Op::JZ : Op::JNZ, label, value.reg);
+    }
+
+    // switch expr [value: label, ...] default label; the operand is compared as an int
+    void translateSwitch(const string& stmt) {
+        size_t open = stmt.find(" [");
+        size_t close = stmt.rfind("] default ");
+        if (open == string::npos || close == string::npos || close < open) return;
+        int32_t defaultLabel = labelOf(trimmed(stmt.substr(close + 10)));
+        if (defaultLabel < 0) return;
+
+        Operand value = valueOf(trimmed(stmt.substr(7, open - 7)));
+        value = convert(value, Kind::I32);
+
+        vector<pair<int32_t, int32_t>> cases;
+        for (const string& entry : splitTACArguments(stmt.substr(open + 2, close - open - 2))) {
+            size_t colon = entry.find(": ");
+            if (colon == string::npos) continue;
+            int32_t label = labelOf(entry.substr(colon + 2));
+            if (label < 0) continue;
+            cases.push_back({static_cast<int32_t>(strtol(entry.substr(0, colon).c_str(), nullptr, 10)), label});
+        }
+        int32_t table = static_cast<int32_t>(switchTables.size() - firstSwitchTable);
+        switchTables.emplace_back();
+        switchCases.push_back(std::move(cases));
+        switchDefaults.push_back({table, defaultLabel});
+        emit(Op::SWITCH, value.reg, static_cast<int32_t>(firstSwitchTable) + table);
+    }
+
+    void translateGoto(const string& stmt) {
+        int32_t label = labelOf(trimmed(stmt.substr(5)));
+        if (label >= 0) emit(Op::JMP, label);
+    }
+
+    // A bare return gives the zero of the return type
+    void translateReturn(const string& stmt) {
+        if (stmt == "return") {
+            emit(Op::RET, -1);
+            return;
+        }
+        Operand value = convert(valueOf(trimmed(stmt.substr(7))), function->returnKind);
+        emit(Op::RET, value.reg);
+    }
+};
+
+// === Execution ===
+
+int32_t TACInterpreter::run() {
+    unique_ptr<Slot[]> stack(new Slot[kStackSlots]);
+    Slot* const stackEnd = stack.get() + kStackSlots;
+    vector<CallFrame> frames;
+    frames.reserve(64);
+
+    const InterpFunction* current = &functions[functionIndex.at("main")];
+    Slot* r = stack.get();
+    const Instr* pc = nullptr;
+    Slot result = zeroSlot();
+
+    // Fresh frame: constants copied in, everything else zero
+    auto enter = [&](const InterpFunction& callee, Slot* frame) -> bool {
+        if (stackEnd - frame < callee.frameSize) return false;
+        Slot* variables = copy(callee.constants.begin(), callee.constants.end(), frame);
+        memset(variables, 0, (frame + callee.frameSize - variables) * sizeof(Slot));
+        return true;
+    };
+    if (!enter(*current, r)) throw RuntimeError("stack overflow");
+    pc = current->code.data();
+
+#if defined(__GNUC__)
+    static const void* const handlers[] = {
+#define INTERP_OP_HANDLER(name, regs) &&handle_##name,
+        INTERP_OPS(INTERP_OP_HANDLER)
+#undef INTERP_OP_HANDLER
+    };
+#define DISPATCH() goto *handlers[static_cast<size_t>(pc->op)]
+#else
+#define DISPATCH() goto dispatch
+#endif
+#define NEXT() do { ++pc; DISPATCH(); } while (0)
+#define A r[pc->a]
+#define B r[pc->b]
+#define C r[pc->c]
+#define WRAP(expr) static_cast<int32_t>(expr)
+#define U(x) static_cast<uint32_t>(x)
+
+    DISPATCH();
+#if !defined(__GNUC__)
+dispatch:
+    switch (pc->op) {
+#define INTERP_OP_CASE(name, regs) case Op::name: goto handle_##name;
+        INTERP_OPS(INTERP_OP_CASE)
+#undef INTERP_OP_CASE
+    }
+#endif
+
+handle_MOVE: A = B; NEXT();
+handle_I32_TO_I8: A.i = static_cast<signed char>(B.i); NEXT();
+handle_I8_TO_I32: A.i = B.i & 0xFF; NEXT();
+handle_I32_TO_F32: A.f = static_cast<float>(B.i); NEXT();
+handle_I32_TO_F64: A.d = static_cast<double>(B.i); NEXT();
+handle_F32_TO_F64: A.d = B.f; NEXT();
+handle_F64_TO_F32: A.f = static_cast<float>(B.d); NEXT();
+handle_F32_TO_I32: A.i = toInt32(B.f); NEXT();
+handle_F64_TO_I32: A.i = toInt32(B.d); NEXT();
+
+handle_ADD_I32: A.i = WRAP(U(B.i) + U(C.i)); NEXT();
+handle_SUB_I32: A.i = WRAP(U(B.i) - U(C.i)); NEXT();
+handle_MUL_I32: A.i = WRAP(U(B.i) * U(C.i)); NEXT();
+handle_DIV_I32:
+    if (C.i == 0 || (B.i == INT32_MIN && C.i == -1)) throw RuntimeError("integer division by zero or overflow in " + current->name);
+    A.i = B.i / C.i; NEXT();
+handle_MOD_I32:
+    if (C.i == 0 || (B.i == INT32_MIN && C.i == -1)) throw RuntimeError("integer division by zero or overflow in " + current->name);
+    A.i = B.i % C.i; NEXT();
+handle_AND_I32: A.i = B.i & C.i; NEXT();
+handle_OR_I32: A.i = B.i | C.i; NEXT();
+handle_XOR_I32: A.i = B.i ^ C.i; NEXT();
+handle_SHL_I32: A.i = WRAP(U(B.i) << (C.i & 31)); NEXT();
+handle_SHR_I32: A.i = B.i >> (C.i & 31); NEXT();
+handle_NEG_I32: A.i = WRAP(0u - U(B.i)); NEXT();
+handle_NOT_I32: A.i = ~B.i; NEXT();
+
+handle_ADD_F32: A.f = B.f + C.f; NEXT();
+handle_SUB_F32: A.f = B.f - C.f; NEXT();
+handle_MUL_F32: A.f = B.f * C.f; NEXT();
+handle_DIV_F32: A.f = B.f / C.f; NEXT();
+handle_NEG_F32: A.f = -B.f; NEXT();
+handle_ADD_F64: A.d = B.d + C.d; NEXT();
+handle_SUB_F64: A.d = B.d - C.d; NEXT();
+handle_MUL_F64: A.d = B.d * C.d; NEXT();
+handle_DIV_F64: A.d = B.d / C.d; NEXT();
+handle_NEG_F64: A.d = -B.d; NEXT();
+
+    // Floating point comparisons are ordered: false when either side is NaN, != included
+handle_EQ_I32: A.i = B.i == C.i; NEXT();
+handle_NE_I32: A.i = B.i != C.i; NEXT();
+handle_LT_I32: A.i = B.i < C.i; NEXT();
+handle_GT_I32: A.i = B.i > C.i; NEXT();
+handle_LE_I32: A.i = B.i <= C.i; NEXT();
+handle_GE_I32: A.i = B.i >= C.i; NEXT();
+handle_EQ_F32: A.i = B.f == C.f; NEXT();
+handle_NE_F32: A.i = B.f < C.f || B.f > C.f; NEXT();
+handle_LT_F32: A.i = B.f < C.f; NEXT();
+handle_GT_F32: A.i = B.f > C.f; NEXT();
+handle_LE_F32: A.i = B.f <= C.f; NEXT();
+handle_GE_F32: A.i = B.f >= C.f; NEXT();
+handle_EQ_F64: A.i = B.d == C.d; NEXT();
+handle_NE_F64: A.i = B.d < C.d || B.d > C.d; NEXT();
+handle_LT_F64: A.i = B.d < C.d; NEXT();
+handle_GT_F64: A.i = B.d > C.d; NEXT();
+handle_LE_F64: A.i = B.d <= C.d; NEXT();
+handle_GE_F64: A.i = B.d >= C.d; NEXT();
+handle_EQ_PTR: A.i = B.s == C.s; NEXT();
+handle_NE_PTR: A.i = B.s != C.s; NEXT();
+handle_LT_PTR: A.i = B.s < C.s; NEXT();
+handle_GT_PTR: A.i = B.s > C.s; NEXT();
+handle_LE_PTR: A.i = B.s <= C.s; NEXT();
+handle_GE_PTR: A.i = B.s >= C.s; NEXT();
+
+handle_JMP: pc = current->code.data() + pc->a; DISPATCH();
+handle_JZ: if (B.i == 0) { pc = current->code.data() + pc->a; DISPATCH(); } NEXT();
+handle_JNZ: if (B.i != 0) { pc = current->code.data() + pc->a; DISPATCH(); } NEXT();
+handle_BEQ: if (B.i == C.i) { pc = current->code.data() + pc->a; DISPATCH(); } NEXT();
+handle_BNE: if (B.i != C.i) { pc = current->code.data() + pc->a; DISPATCH(); } NEXT();
+handle_BLT: if (B.i < C.i) { pc = current->code.data() + pc->a; DISPATCH(); } NEXT();
+handle_BGT: if (B.i > C.i) { pc = current->code.data() + pc->a; DISPATCH(); } NEXT();
+handle_BLE: if (B.i <= C.i) { pc = current->code.data() + pc->a; DISPATCH(); } NEXT();
+handle_BGE: if (B.i >= C.i) { pc = current->code.data() + pc->a; DISPATCH(); } NEXT();
+
+handle_SWITCH: {
+    const SwitchTable& table = switchTables[pc->b];
+    int32_t value = A.i;
+    int32_t target = table.defaultTarget;
+    if (!table.dense.empty()) {
+        int64_t index = static_cast<int64_t>(value) - table.low;
+        if (index >= 0 && index < static_cast<int64_t>(table.dense.size()) && table.dense[index] >= 0) {
+            target = table.dense[index];
+        }
+    } else {
+        auto it = lower_bound(table.sparse.begin(), table.sparse.end(), make_pair(value, INT32_MIN));
+        if (it != table.sparse.end() && it->first == value) target = it->second;
+    }
+    pc = current->code.data() + target;
+    DISPATCH();
+}
+
+handle_CALL: {
+    const InterpFunction& callee = functions[pc->b];
+    Slot* frame = r + current->frameSize;
+    if (!enter(callee, frame)) throw RuntimeError("stack overflow in " + callee.name);
+    const int32_t* args = argumentLists.data() + pc->c;
+    for (int32_t i = 0; i < args[0]; i++) frame[callee.paramRegisters[i]] = r[args[i + 1]];
+    frames.push_back({current, pc + 1, r, pc->a});
+    current = &callee;
+    r = frame;
+    pc = callee.code.data();
+    DISPATCH();
+}
+
+handle_RET: {
+    Slot value = pc->a >= 0 ? A : zeroSlot();
+    if (frames.empty()) {
+        result = value;
+        goto finished;
+    }
+    const CallFrame& caller = frames.back();
+    current = caller.function;
+    r = caller.registers;
+    pc = caller.returnAddress;
+    if (caller.destination >= 0) r[caller.destination] = value;
+    frames.pop_back();
+    DISPATCH();
+}
+
+handle_PRINT_I32: __rt_print_int(A.i); NEXT();
+handle_PRINT_CHAR: __rt_print_char(A.i & 0xFF); NEXT();
+handle_PRINT_F32: __rt_print_float(A.f); NEXT();
+handle_PRINT_F64: __rt_print_float(A.d); NEXT();
+handle_PRINT_STR: __rt_print_str(A.s); NEXT();
+handle_PRINT_TEXT: {
+    const string& text = strings[pc->a];
+    if (text.size() == 1) __rt_print_char(static_cast<unsigned char>(text[0]));
+    else __rt_print_str(text.c_str());
+    NEXT();
+}
+
+#undef DISPATCH
+#undef NEXT
+#undef A
+#undef B
+#undef C
+#undef WRAP
+#undef U
+
+finished:
+    return result.i;
+}
+
+} // namespace
+
+RunStats interpretTACProgram(const string& tacFile) {
+    auto ms = [](auto a, auto b) { return chrono::duration<double, milli>(b - a).count(); };
+    auto buildStart = chrono::steady_clock::now();
+    RunStats stats;
+
+    TACInterpreter interpreter;
+    if (!interpreter.readTACFile(tacFile)) {
+        throw CompilationError("cannot read " + tacFile);
+    }
+    interpreter.translate();
+    stats.buildMs = ms(buildStart, chrono::steady_clock::now());
+
+    if (!compilerOptions.quiet) {
+        cout << "\033[1m\033[95m========== EXECUTING PROGRAM ==========\033[0m\n";
+    }
+    if (!interpreter.hasMain()) {
+        cerr << "Error: No main function found\n";
+        throw CompilationError("cannot run program");
+    }
+    cout.flush();
+
+    {
+        PhaseTimer timer("execute");
+        auto execStart = chrono::steady_clock::now();
+        try {
+            int32_t result = interpreter.run();
+            if (!interpreter.mainReturnsVoid()) stats.exitCode = result;
+        } catch (const RuntimeError& e) {
+            __rt_flush();
+            cerr << "\nRuntime Error: " << e.what() << endl;
+            throw CompilationError("program failed");
+        }
+        __rt_flush();
+        stats.executeMs = ms(execStart, chrono::steady_clock::now());
+    }
+
+    if (!compilerOptions.quiet) {
+        cout << "=======================================\n";
+    }
+    cout.flush();
+    return stats;
+}
@@ -502,11 +502,13 @@ const char* tokenTypeToString(TokenType type) {
 /* ======== */
 
 vector<Token> lexAndDumpToFile(const string& inputFilename, const string& outputFilename) {
+    PhaseTimer timer("lex");
+
     // Read the input file
     ifstream inputFile(inputFilename);
     if (!inputFile.is_open()) {
         cerr << "Failed to open input file: " << inputFilename << endl;
-        return {};
+        throw CompilationError("cannot open " + inputFilename);
     }
 
     stringstream buffer;
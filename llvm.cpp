@@ -1,30 +1,34 @@
-#include "compiler.h"
+#include "backend.h"
 
-#include <llvm/IR/LLVMContext.h>
-#include <llvm/IR/Module.h>
-#include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/Verifier.h>
-#include <llvm/ExecutionEngine/ExecutionEngine.h>
-#include <llvm/ExecutionEngine/GenericValue.h>
-#include <llvm/ExecutionEngine/MCJIT.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
 #include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Transforms/Utils/Mem2Reg.h>
+#include <llvm/Target/TargetMachine.h>
+#include <llvm/Target/TargetOptions.h>
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/SHA1.h>
+#include <llvm/Support/Process.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/ExecutionEngine/ObjectCache.h>
+#include <llvm/ExecutionEngine/Orc/CompileUtils.h>
+#include <llvm/Config/llvm-config.h>
 
 #include <algorithm>
+#include <chrono>
+#include <cstdio>
 
 using namespace llvm;
 using namespace std;
 
-enum class VarType {
-    INT,
-    FLOAT,
-    DOUBLE,
-    CHAR,
-    STRING,
-    BOOL,
-    VOID,
-    UNKNOWN
-};
-
 struct VariableInfo {
     AllocaInst* alloca;
     VarType type;
@@ -37,9 +41,229 @@ struct FunctionInfo {
     VarType returnType;
 };
 
+// === Print Lowering ===
+
+string processEscapes(const string& str) {
+    string processed;
+    for (size_t i = 0; i < str.length(); i++) {
+        if (str[i] == '\\' && i + 1 < str.length()) {
+            switch (str[i + 1]) {
+                case 'n': processed += '\n'; i++; break;
+                case 't': processed += '\t'; i++; break;
+                case 'r': processed += '\r'; i++; break;
+                case '\\': processed += '\\'; i++; break;
+                case '"': processed += '"'; i++; break;
+                case '0': processed += '\0'; i++; break;
+                default:
+                    // Keep backslash and next char as-is for unknown sequences
+                    processed += str[i];
+                    processed += str[i + 1];
+                    i++;
+                    break;
+            }
+        } else {
+            processed += str[i];
+        }
+    }
+    return processed;
+}
+
+PrintLowering::PrintLowering(Module& m) : module(m) {
+    LLVMContext& ctx = module.getContext();
+    Type* voidTy = Type::getVoidTy(ctx);
+    Type* int32Ty = Type::getInt32Ty(ctx);
+    printInt = module.getOrInsertFunction("__rt_print_int", voidTy, int32Ty);
+    printFloat = module.getOrInsertFunction("__rt_print_float", voidTy, Type::getDoubleTy(ctx));
+    printStr = module.getOrInsertFunction("__rt_print_str", voidTy, PointerType::getUnqual(Type::getInt8Ty(ctx)));
+    printChar = module.getOrInsertFunction("__rt_print_char", voidTy, int32Ty);
+}
+
+Constant* PrintLowering::stringConstant(IRBuilder<>& builder, const string& str) {
+    auto it = strings.find(str);
+    if (it != strings.end()) return it->second;
+    Constant* ptr = builder.CreateGlobalStringPtr(str, ".str", 0, &module);
+    strings[str] = ptr;
+    return ptr;
+}
+
+void PrintLowering::emitText(IRBuilder<>& builder, const string& text) {
+    if (text.empty()) return;
+    if (text.size() == 1) {
+        builder.CreateCall(printChar, {builder.getInt32(static_cast<unsigned char>(text[0]))});
+    } else {
+        builder.CreateCall(printStr, {stringConstant(builder, text)});
+    }
+}
+
+void PrintLowering::emit(IRBuilder<>& builder, const vector<PrintPiece>& pieces) {
+    string text;
+    for (const PrintPiece& piece : pieces) {
+        Value* val = piece.value;
+        if (!val) {
+            text += piece.text;
+            continue;
+        }
+        
+        Type* valType = val->getType();
+        if (auto constant = dyn_cast<ConstantInt>(val)) {
+            if (valType->isIntegerTy(8)) text += static_cast<char>(constant->getZExtValue());
+            else if (valType->isIntegerTy(1)) text += to_string(constant->getZExtValue());
+            else text += to_string(constant->getSExtValue());
+            continue;
+        }
+        
+        emitText(builder, text);
+        text.clear();
+        if (valType->isPointerTy()) {
+            builder.CreateCall(printStr, {val});
+        } else if (valType->isFloatingPointTy()) {
+            builder.CreateCall(printFloat, {builder.CreateFPExt(val, builder.getDoubleTy())});
+        } else if (valType->isIntegerTy(8)) {
+            builder.CreateCall(printChar, {builder.CreateZExt(val, builder.getInt32Ty())});
+        } else if (valType->isIntegerTy()) {
+            builder.CreateCall(printInt, {builder.CreateZExtOrTrunc(val, builder.getInt32Ty())});
+        }
+    }
+    emitText(builder, text);
+}
+
+// === JIT Support ===
+
+// On-disk object cache: <cacheDir>/<module identifier>.o. Modules compiled for the cache are
+// named after the compilation cache key, so a rerun of an unchanged program with the same
+// flags can load the object without going through the front end at all.
+class DiskObjectCache : public ObjectCache {
+private:
+    string directory;
+
+    string pathFor(const Module* m) const {
+        return directory + "/" + m->getModuleIdentifier() + ".o";
+    }
+
+public:
+    explicit DiskObjectCache(const string& dir) : directory(dir) {}
+
+    void notifyObjectCompiled(const Module* m, MemoryBufferRef obj) override {
+        if (sys::fs::create_directories(directory)) return;
+        // Written under a temporary name and renamed, so concurrent CI jobs never see half an object
+        string path = pathFor(m);
+        string tmpPath = path + ".tmp" + to_string(sys::Process::getProcessId());
+        error_code ec;
+        {
+            raw_fd_ostream out(tmpPath, ec, sys::fs::OF_None);
+            if (ec) return;
+            out << obj.getBuffer();
+        }
+        if (sys::fs::rename(tmpPath, path)) {
+            sys::fs::remove(tmpPath);
+        }
+    }
+
+    unique_ptr<MemoryBuffer> getObject(const Module* m) override {
+        auto buffer = MemoryBuffer::getFile(pathFor(m));
+        return buffer ? std::move(*buffer) : nullptr;
+    }
+};
+
+// ORC JIT whose main JITDylib binds the output runtime and resolves libc against the host process
+static unique_ptr<orc::LLJIT> createHostJIT(bool lazy, ObjectCache* cache) {
+    InitializeNativeTarget();
+    InitializeNativeTargetAsmPrinter();
+    InitializeNativeTargetAsmParser();
+    
+    unique_ptr<orc::LLJIT> jit;
+    if (lazy) {
+        auto created = orc::LLLazyJITBuilder().create();
+        if (!created) {
+            errs() << "JIT Error: " << toString(created.takeError()) << "\n";
+            return nullptr;
+        }
+        jit = std::move(*created);
+    } else {
+        orc::LLJITBuilder builder;
+        if (cache) {
+            builder.setCompileFunctionCreator([cache](orc::JITTargetMachineBuilder jtmb)
+                    -> Expected<unique_ptr<orc::IRCompileLayer::IRCompiler>> {
+                return make_unique<orc::ConcurrentIRCompiler>(std::move(jtmb), cache);
+            });
+        }
+        auto created = builder.create();
+        if (!created) {
+            errs() << "JIT Error: " << toString(created.takeError()) << "\n";
+            return nullptr;
+        }
+        jit = std::move(*created);
+    }
+    
+    auto hostSymbols = orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+        jit->getDataLayout().getGlobalPrefix());
+    if (!hostSymbols) {
+        errs() << "JIT Error: " << toString(hostSymbols.takeError()) << "\n";
+        return nullptr;
+    }
+    jit->getMainJITDylib().addGenerator(std::move(*hostSymbols));
+    
+    orc::SymbolMap runtimeSymbols;
+    auto bind = [&](const char* name, auto* function) {
+        runtimeSymbols[jit->mangleAndIntern(name)] = JITEvaluatedSymbol(
+            pointerToJITTargetAddress(function), JITSymbolFlags::Exported | JITSymbolFlags::Callable);
+    };
+    bind("__rt_print_int", &__rt_print_int);
+    bind("__rt_print_float", &__rt_print_float);
+    bind("__rt_print_str", &__rt_print_str);
+    bind("__rt_print_char", &__rt_print_char);
+    if (Error err = jit->getMainJITDylib().define(orc::absoluteSymbols(std::move(runtimeSymbols)))) {
+        errs() << "JIT Error: " << toString(std::move(err)) << "\n";
+        return nullptr;
+    }
+    return jit;
+}
+
+// Looks main up (which compiles it, or only its stub when lazy) and calls it natively through a
+// typed pointer; main's result becomes the exit code. jitStart marks when JIT setup began.
+static bool runJITMain(orc::LLJIT& jit, bool returnsVoid, chrono::steady_clock::time_point jitStart,
+                       RunStats& stats) {
+    auto ms = [](auto a, auto b) { return chrono::duration<double, milli>(b - a).count(); };
+    JITTargetAddress mainAddress = 0;
+    {
+        PhaseTimer timer("jit-finalize");
+        auto mainSym = jit.lookup("main");
+        if (!mainSym) {
+            errs() << "JIT Error: " << toString(mainSym.takeError()) << "\n";
+            return false;
+        }
+        mainAddress = mainSym->getAddress();
+    }
+    stats.jitMs = ms(jitStart, chrono::steady_clock::now());
+    
+    {
+        // Banner and IR are written through llvm::outs(), which buffers apart from stdio
+        outs().flush();
+        PhaseTimer timer("execute");
+        auto execStart = chrono::steady_clock::now();
+        if (returnsVoid) {
+            jitTargetAddressToFunction<void (*)()>(mainAddress)();
+        } else {
+            stats.exitCode = jitTargetAddressToFunction<int (*)()>(mainAddress)();
+        }
+        // Program output is still in the runtime's buffer; it counts as part of the run
+        __rt_flush();
+        stats.executeMs = ms(execStart, chrono::steady_clock::now());
+    }
+    
+    if (!compilerOptions.quiet) {
+        outs() << "=======================================\n";
+    }
+    outs().flush();
+    fflush(stdout);
+    return true;
+}
+
 class TACExecutor {
 private:
-    LLVMContext ctx;
+    // Heap-allocated so run() can hand context and module over to ORC as a ThreadSafeModule
+    unique_ptr<LLVMContext> context;
+    LLVMContext& ctx;
     unique_ptr<Module> module;
     IRBuilder<> builder;
     
@@ -50,12 +274,11 @@ private:
     Type* doubleTy;
     Type* ptrTy;
     
-    Function* printfFunc;
-    Function* putsFunc;
-    Function* putcharFunc;
+    unique_ptr<PrintLowering> printer;
     
     Function* currentFunc;
     BasicBlock* currentBlock;
+    BasicBlock* fallthroughBlock = nullptr;   // block after the current one, where a conditional jump continues
     
     map<string, VariableInfo> namedValues;
     map<string, pair<Value*, VarType>> tempValues;
@@ -66,7 +289,7 @@ private:
     size_t currentLine;
     
 public:
-    TACExecutor() : builder(ctx), currentFunc(nullptr), currentBlock(nullptr), currentLine(0) {
+    TACExecutor() : context(make_unique<LLVMContext>()), ctx(*context), builder(ctx), currentFunc(nullptr), currentBlock(nullptr), currentLine(0) {
         module = make_unique<Module>("TACModule", ctx);
         
         voidTy = Type::getVoidTy(ctx);
@@ -74,26 +297,9 @@ public:
         int8Ty = Type::getInt8Ty(ctx);
         floatTy = Type::getFloatTy(ctx);
         doubleTy = Type::getDoubleTy(ctx);
-        ptrTy = PointerType::getUnqual(ctx);
+        ptrTy = PointerType::getUnqual(int8Ty);
         
-        declarePrintf();
-        declarePuts();
-        declarePutchar();
-    }
-    
-    void declarePrintf() {
-        FunctionType* printfTy = FunctionType::get(int32Ty, {ptrTy}, true);
-        printfFunc = Function::Create(printfTy, Function::ExternalLinkage, "printf", module.get());
-    }
-    
-    void declarePuts() {
-        FunctionType* putsTy = FunctionType::get(int32Ty, {ptrTy}, false);
-        putsFunc = Function::Create(putsTy, Function::ExternalLinkage, "puts", module.get());
-    }
-    
-    void declarePutchar() {
-        FunctionType* putcharTy = FunctionType::get(int32Ty, {int32Ty}, false);
-        putcharFunc = Function::Create(putcharTy, Function::ExternalLinkage, "putchar", module.get());
+        printer = make_unique<PrintLowering>(*module);
     }
     
     bool readTACFile(const string& filename) {
@@ -141,15 +347,28 @@ public:
         }
     }
     
-    void execute() {
-        firstPass();
-        secondPass();
-        
-        string errStr;
-        raw_string_ostream errStream(errStr);
-        if (verifyModule(*module, &errStream)) {
-            errs() << "Module verification failed:\n" << errStr << "\n";
+    // Builds the module from the TAC lines and hands it over together with its context
+    LoweredProgram lower() {
+        {
+            PhaseTimer timer("ir-build");
+            firstPass();
+            secondPass();
         }
+        
+        LoweredProgram program;
+        auto mainIt = functions.find("main");
+        program.mainReturnsVoid = mainIt != functions.end() && mainIt->second.returnType == VarType::VOID;
+        program.module = std::move(module);
+        program.context = std::move(context);
+        return program;
+    }
+    
+    // mem2reg only promotes allocas in the entry block, so locals are created there no
+    // matter where in the function they are first assigned (e.g. inside a loop body)
+    AllocaInst* createEntryAlloca(Type* type, const string& name) {
+        BasicBlock& entry = currentFunc->getEntryBlock();
+        IRBuilder<> entryBuilder(&entry, entry.begin());
+        return entryBuilder.CreateAlloca(type, nullptr, name);
     }
     
     void firstPass() {
@@ -232,6 +451,7 @@ public:
     void processFunction() {
         string line = tacLines[currentLine];
         string funcName = extractFunctionName(line);
+        TRACE_SCOPE("processFunction", funcName);
         
         FunctionInfo& funcInfo = functions[funcName];
         currentFunc = funcInfo.func;
@@ -256,7 +476,7 @@ public:
                 }
                 
                 Type* llvmType = getLLVMType(paramType);
-                AllocaInst* alloca = builder.CreateAlloca(llvmType, nullptr, paramName);
+                AllocaInst* alloca = createEntryAlloca(llvmType, paramName);
                 builder.CreateStore(&arg, alloca);
                 namedValues[paramName] = {alloca, paramType};
                 
@@ -264,45 +484,52 @@ public:
             }
         }
         
-        // Pre-scan for labels
-        size_t startLine = currentLine;
-        while (currentLine < tacLines.size()) {
-            string l = tacLines[currentLine];
-            if (l.find("function ") != string::npos && l.find(" end") != string::npos) {
-                break;
-            }
-            if (!l.empty() && l.back() == ':') {
-                string labelName = l.substr(0, l.size() - 1);
-                labels[labelName] = BasicBlock::Create(ctx, labelName, currentFunc);
-            }
+        // Body statements up to `function ... end`, split into blocks
+        size_t bodyBegin = currentLine;
+        while (currentLine < tacLines.size() && !(tacLines[currentLine].find("function ") != string::npos &&
+                                                  tacLines[currentLine].find(" end") != string::npos)) {
             currentLine++;
         }
+        size_t bodyEnd = currentLine;
+        vector<TACControl> controls;
+        controls.reserve(bodyEnd - bodyBegin);
+        for (size_t i = bodyBegin; i < bodyEnd; i++) controls.push_back(classifyTACStatement(tacLines[i]));
+        TACControlFlowGraph cfg = buildTACControlFlowGraph(controls);
         
-        currentLine = startLine;
+        // One LLVM block per reachable TAC block, named after its label. The entry block holds the
+        // allocas and cannot be a jump target, so a labeled first block gets a block of its own.
+        vector<BasicBlock*> blocks(cfg.blocks.size(), nullptr);
+        for (size_t b = 0; b < cfg.blocks.size(); b++) {
+            const TACBlock& block = cfg.blocks[b];
+            if (!block.reachable) continue;
+            bool labeled = block.end > block.begin && controls[block.begin].kind == TACControl::LABEL;
+            if (b == 0 && !labeled) {
+                blocks[b] = currentBlock;
+                continue;
+            }
+            string name = labeled ? string(controls[block.begin].label) : "bb";
+            blocks[b] = BasicBlock::Create(ctx, name, currentFunc);
+            if (labeled) labels[name] = blocks[b];
+        }
+        if (blocks[0] != currentBlock) builder.CreateBr(blocks[0]);
         
-        // Process function body
-        while (currentLine < tacLines.size()) {
-            string l = tacLines[currentLine];
-            
-            if (l.find("function ") != string::npos && l.find(" end") != string::npos) {
-                if (!currentBlock->getTerminator()) {
-                    if (funcInfo.returnType == VarType::VOID) {
-                        builder.CreateRetVoid();
-                    } else if (funcInfo.returnType == VarType::FLOAT) {
-                        builder.CreateRet(ConstantFP::get(floatTy, 0.0));
-                    } else if (funcInfo.returnType == VarType::DOUBLE) {
-                        builder.CreateRet(ConstantFP::get(doubleTy, 0.0));
-                    } else {
-                        builder.CreateRet(ConstantInt::get(int32Ty, 0));
-                    }
-                }
-                currentLine++;
-                break;
+        // Unreachable blocks are skipped; a block that does not end in a jump falls into the
+        // next one, the last into a default return
+        for (size_t b = 0; b < cfg.blocks.size(); b++) {
+            if (!blocks[b]) continue;
+            currentBlock = blocks[b];
+            builder.SetInsertPoint(currentBlock);
+            fallthroughBlock = b + 1 < blocks.size() ? blocks[b + 1] : nullptr;
+            for (size_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+                processStatement(tacLines[bodyBegin + i]);
+            }
+            if (!currentBlock->getTerminator()) {
+                if (fallthroughBlock) builder.CreateBr(fallthroughBlock);
+                else createDefaultReturn();
             }
-            
-            processStatement(l);
-            currentLine++;
         }
+        
+        if (currentLine < tacLines.size()) currentLine++;
     }
     
     void processStatement(const string& stmt) {
@@ -310,28 +537,22 @@ public:
             return;
         }
         
-        if (currentBlock->getTerminator()) {
+        // A label starts its block, which processFunction has already entered
+        if (stmt.back() == ':' || currentBlock->getTerminator()) {
             return;
         }
         
-        // Handle labels
-        if (!stmt.empty() && stmt.back() == ':') {
-            string labelName = stmt.substr(0, stmt.size() - 1);
-            BasicBlock* labelBlock = labels[labelName];
-            
-            if (!currentBlock->getTerminator()) {
-                builder.CreateBr(labelBlock);
-            }
-            
-            currentBlock = labelBlock;
-            builder.SetInsertPoint(currentBlock);
-            return;
+        // A call statement is checked first: its string arguments may contain " = "
+        if (stmt.find("call ") == 0) {
+            processFunctionCall(stmt);
         }
-        
-        if (stmt.find(" = ") != string::npos) {
+        else if (stmt.find("switch ") == 0) {
+            processSwitch(stmt);
+        }
+        else if (stmt.find(" = ") != string::npos) {
             processAssignment(stmt);
         }
-        else if (stmt.find("if ") == 0 && stmt.find(" goto ") != string::npos) {
+        else if ((stmt.find("if ") == 0 || stmt.find("ifFalse ") == 0) && stmt.find(" goto ") != string::npos) {
             processConditionalGoto(stmt);
         }
         else if (stmt.find("goto ") == 0) {
@@ -340,9 +561,6 @@ public:
         else if (stmt.find("return") == 0) {
             processReturn(stmt);
         }
-        else if (stmt.find("call ") == 0) {
-            processFunctionCall(stmt);
-        }
     }
     
     VarType extractTypeFromDeclaration(const string& lhs, string& varName) {
@@ -420,19 +638,58 @@ public:
             result = convertToType(result, resultType);
         }
         
-        // Store result
-        if (varName[0] == 't' && declaredType == VarType::UNKNOWN) {
+        // Store result (a declared variable may also start with 't', e.g. `total`)
+        if (varName[0] == 't' && declaredType == VarType::UNKNOWN &&
+            namedValues.find(varName) == namedValues.end()) {
             tempValues[varName] = {result, resultType};
         } else {
             if (namedValues.find(varName) == namedValues.end()) {
                 Type* llvmType = getLLVMType(resultType);
-                AllocaInst* alloca = builder.CreateAlloca(llvmType, nullptr, varName);
+                AllocaInst* alloca = createEntryAlloca(llvmType, varName);
                 namedValues[varName] = {alloca, resultType};
             }
             builder.CreateStore(result, namedValues[varName].alloca);
         }
     }
     
+    static bool isComparison(const string& op) {
+        return op == "eq" || op == "ne" || op == "lt" || op == "gt" || op == "le" || op == "ge";
+    }
+    
+    // i1 result of a comparison, shared by `t = a < b` and fused conditional jumps. Floating point
+    // if either side is (the other side converted), otherwise integers; a char compared with a
+    // wider int is zero-extended.
+    Value* buildComparison(const string& op, Value* lVal, Value* rVal) {
+        Type* lType = lVal->getType();
+        Type* rType = rVal->getType();
+        
+        if (lType->isFloatingPointTy() || rType->isFloatingPointTy()) {
+            VarType type = (lType->isDoubleTy() || rType->isDoubleTy()) ? VarType::DOUBLE : VarType::FLOAT;
+            if (lType != rType) {
+                Type* targetType = getLLVMType(type);
+                if (lType != targetType) lVal = convertToType(lVal, type);
+                if (rType != targetType) rVal = convertToType(rVal, type);
+            }
+            if (op == "eq") return builder.CreateFCmpOEQ(lVal, rVal);
+            if (op == "ne") return builder.CreateFCmpONE(lVal, rVal);
+            if (op == "lt") return builder.CreateFCmpOLT(lVal, rVal);
+            if (op == "gt") return builder.CreateFCmpOGT(lVal, rVal);
+            if (op == "le") return builder.CreateFCmpOLE(lVal, rVal);
+            return builder.CreateFCmpOGE(lVal, rVal);
+        }
+        
+        if (lType->isIntegerTy() && rType->isIntegerTy() && lType != rType) {
+            if (lType->getIntegerBitWidth() < 32) lVal = builder.CreateZExt(lVal, int32Ty);
+            if (rType->getIntegerBitWidth() < 32) rVal = builder.CreateZExt(rVal, int32Ty);
+        }
+        if (op == "eq") return builder.CreateICmpEQ(lVal, rVal);
+        if (op == "ne") return builder.CreateICmpNE(lVal, rVal);
+        if (op == "lt") return builder.CreateICmpSLT(lVal, rVal);
+        if (op == "gt") return builder.CreateICmpSGT(lVal, rVal);
+        if (op == "le") return builder.CreateICmpSLE(lVal, rVal);
+        return builder.CreateICmpSGE(lVal, rVal);
+    }
+    
     pair<Value*, VarType> processBinaryOp(const string& expr) {
         vector<pair<string, string>> ops = {
             {" << ", "shl"}, {" >> ", "shr"},
@@ -457,6 +714,10 @@ public:
                 auto [lVal, lType] = getValueWithType(left);
                 auto [rVal, rType] = getValueWithType(right);
                 
+                if (isComparison(op.second)) {
+                    return {builder.CreateZExt(buildComparison(op.second, lVal, rVal), int32Ty), VarType::INT};
+                }
+                
                 // Determine result type based on operand types
                 VarType resultType = VarType::INT;
                 Type* lLLVMType = lVal->getType();
@@ -496,30 +757,6 @@ public:
                 else if (op.second == "mul") result = isFloat ? builder.CreateFMul(lVal, rVal) : builder.CreateMul(lVal, rVal);
                 else if (op.second == "div") result = isFloat ? builder.CreateFDiv(lVal, rVal) : builder.CreateSDiv(lVal, rVal);
                 else if (op.second == "mod") result = builder.CreateSRem(lVal, rVal);
-                else if (op.second == "eq") {
-                    result = isFloat ? builder.CreateFCmpOEQ(lVal, rVal) : builder.CreateICmpEQ(lVal, rVal);
-                    resultType = VarType::INT;
-                }
-                else if (op.second == "ne") {
-                    result = isFloat ? builder.CreateFCmpONE(lVal, rVal) : builder.CreateICmpNE(lVal, rVal);
-                    resultType = VarType::INT;
-                }
-                else if (op.second == "lt") {
-                    result = isFloat ? builder.CreateFCmpOLT(lVal, rVal) : builder.CreateICmpSLT(lVal, rVal);
-                    resultType = VarType::INT;
-                }
-                else if (op.second == "gt") {
-                    result = isFloat ? builder.CreateFCmpOGT(lVal, rVal) : builder.CreateICmpSGT(lVal, rVal);
-                    resultType = VarType::INT;
-                }
-                else if (op.second == "le") {
-                    result = isFloat ? builder.CreateFCmpOLE(lVal, rVal) : builder.CreateICmpSLE(lVal, rVal);
-                    resultType = VarType::INT;
-                }
-                else if (op.second == "ge") {
-                    result = isFloat ? builder.CreateFCmpOGE(lVal, rVal) : builder.CreateICmpSGE(lVal, rVal);
-                    resultType = VarType::INT;
-                }
                 else if (op.second == "logand" || op.second == "bitand") result = builder.CreateAnd(lVal, rVal);
                 else if (op.second == "logor" || op.second == "bitor") result = builder.CreateOr(lVal, rVal);
                 else if (op.second == "bitxor") result = builder.CreateXor(lVal, rVal);
@@ -598,7 +835,7 @@ public:
         // String literal
         if (name.size() >= 2 && name[0] == '"' && name.back() == '"') {
             string str = name.substr(1, name.size() - 2);
-            return {builder.CreateGlobalString(str), VarType::STRING};
+            return {printer->stringConstant(builder, str), VarType::STRING};
         }
         
         // Char literal
@@ -640,11 +877,19 @@ public:
         return {ConstantInt::get(int32Ty, 0), VarType::INT};
     }
     
+    // if a < b goto L jumps when the comparison holds, ifFalse a < b goto L when it does not. The
+    // operator is any of == != < > <= >=, compared like `t = a < b`, so a condition becomes one
+    // icmp/fcmp and a branch; a lone operand tests for nonzero.
     void processConditionalGoto(const string& stmt) {
-        size_t ifPos = stmt.find("if ");
+        static const pair<const char*, const char*> comparisons[] = {
+            {" == ", "eq"}, {" != ", "ne"}, {" <= ", "le"}, {" >= ", "ge"}, {" < ", "lt"}, {" > ", "gt"}
+        };
+        
+        bool jumpIfFalse = stmt.find("ifFalse ") == 0;
+        size_t condStart = jumpIfFalse ? 8 : 3;
         size_t gotoPos = stmt.find(" goto ");
         
-        string condition = stmt.substr(ifPos + 3, gotoPos - ifPos - 3);
+        string condition = stmt.substr(condStart, gotoPos - condStart);
         string labelName = stmt.substr(gotoPos + 6);
         
         condition.erase(0, condition.find_first_not_of(" \t"));
@@ -652,75 +897,87 @@ public:
         labelName.erase(0, labelName.find_first_not_of(" \t"));
         labelName.erase(labelName.find_last_not_of(" \t") + 1);
         
-        Value* condValue = nullptr;
+        auto target = labels.find(labelName);
+        if (target == labels.end()) return;
         
-        if (condition.find(" == ") != string::npos) {
-            size_t eqPos = condition.find(" == ");
-            string leftOp = condition.substr(0, eqPos);
-            string rightOp = condition.substr(eqPos + 4);
-            
-            leftOp.erase(0, leftOp.find_first_not_of(" \t"));
+        Value* condValue = nullptr;
+        for (const auto& [pattern, op] : comparisons) {
+            size_t pos = condition.find(pattern);
+            if (pos == string::npos) continue;
+            string leftOp = condition.substr(0, pos);
+            string rightOp = condition.substr(pos + strlen(pattern));
             leftOp.erase(leftOp.find_last_not_of(" \t") + 1);
             rightOp.erase(0, rightOp.find_first_not_of(" \t"));
-            rightOp.erase(rightOp.find_last_not_of(" \t") + 1);
             
-            auto [lVal, lType] = getValueWithType(leftOp);
-            auto [rVal, rType] = getValueWithType(rightOp);
-            
-            // Check if comparing chars
-            if (lVal->getType()->isIntegerTy(8) || rVal->getType()->isIntegerTy(8)) {
-                // Extend char to i32 for comparison
-                if (lVal->getType()->isIntegerTy(8)) {
-                    lVal = builder.CreateZExt(lVal, int32Ty);
-                }
-                if (rVal->getType()->isIntegerTy(8)) {
-                    rVal = builder.CreateZExt(rVal, int32Ty);
-                }
-                condValue = builder.CreateICmpEQ(lVal, rVal);
-            } else {
-                // Regular comparison
-                lVal = convertToType(lVal, VarType::INT);
-                rVal = convertToType(rVal, VarType::INT);
-                condValue = builder.CreateICmpEQ(lVal, rVal);
-            }
-        } else if (condition.find(" != 0") != string::npos) {
-            string var = condition.substr(0, condition.find(" != 0"));
-            var.erase(0, var.find_first_not_of(" \t"));
-            var.erase(var.find_last_not_of(" \t") + 1);
-            auto [val, type] = getValueWithType(var);
-            val = convertToType(val, VarType::INT);
-            condValue = builder.CreateICmpNE(val, ConstantInt::get(int32Ty, 0));
-        } else if (condition.find(" == 0") != string::npos) {
-            string var = condition.substr(0, condition.find(" == 0"));
-            var.erase(0, var.find_first_not_of(" \t"));
-            var.erase(var.find_last_not_of(" \t") + 1);
-            auto [val, type] = getValueWithType(var);
-            val = convertToType(val, VarType::INT);
-            condValue = builder.CreateICmpEQ(val, ConstantInt::get(int32Ty, 0));
-        }
-        
-        if (labels.find(labelName) != labels.end()) {
-            BasicBlock* thenBlock = labels[labelName];
-            BasicBlock* elseBlock = BasicBlock::Create(ctx, "cont", currentFunc);
-            
-            builder.CreateCondBr(condValue, thenBlock, elseBlock);
-            
-            currentBlock = elseBlock;
+            Value* lVal = getValueWithType(leftOp).first;
+            Value* rVal = getValueWithType(rightOp).first;
+            condValue = buildComparison(op, lVal, rVal);
+            break;
+        }
+        if (!condValue) {
+            Value* val = convertToType(getValueWithType(condition).first, VarType::INT);
+            condValue = builder.CreateICmpNE(val, ConstantInt::get(val->getType(), 0));
+        }
+        
+        // The jump ends its block; only a jump at the very end of the function needs a new
+        // block to fall into
+        BasicBlock* fallthrough = fallthroughBlock ? fallthroughBlock : BasicBlock::Create(ctx, "cont", currentFunc);
+        if (jumpIfFalse) builder.CreateCondBr(condValue, fallthrough, target->second);
+        else builder.CreateCondBr(condValue, target->second, fallthrough);
+        
+        if (!fallthroughBlock) {
+            currentBlock = fallthrough;
             builder.SetInsertPoint(currentBlock);
         }
     }
     
+    // switch expr [value: label, ...] default label
+    // The operand is compared like in a conditional jump (chars zero-extended, the rest converted
+    // to int); LLVM lowers the SwitchInst to a jump table, a binary search or compares.
+    void processSwitch(const string& stmt) {
+        size_t open = stmt.find(" [");
+        size_t close = stmt.rfind("] default ");
+        if (open == string::npos || close == string::npos || close < open) return;
+        
+        string expr = stmt.substr(7, open - 7);
+        string defaultName = stmt.substr(close + 10);
+        expr.erase(expr.find_last_not_of(" \t") + 1);
+        defaultName.erase(defaultName.find_last_not_of(" \t") + 1);
+        if (labels.find(defaultName) == labels.end()) return;
+        
+        auto [value, type] = getValueWithType(expr);
+        value = value->getType()->isIntegerTy(8) ? builder.CreateZExt(value, int32Ty)
+                                                 : convertToType(value, VarType::INT);
+        
+        vector<string> cases = splitTACArguments(stmt.substr(open + 2, close - open - 2));
+        SwitchInst* dispatch = builder.CreateSwitch(value, labels[defaultName], cases.size());
+        for (const string& entry : cases) {
+            size_t colon = entry.find(": ");
+            if (colon == string::npos) continue;
+            auto target = labels.find(entry.substr(colon + 2));
+            if (target == labels.end()) continue;
+            int32_t caseValue = stoi(entry.substr(0, colon));
+            dispatch->addCase(builder.getInt32(caseValue), target->second);
+        }
+    }
+    
     void processGoto(const string& stmt) {
         string labelName = stmt.substr(5);
         labelName.erase(0, labelName.find_first_not_of(" \t"));
         labelName.erase(labelName.find_last_not_of(" \t") + 1);
         
-        if (labels.find(labelName) != labels.end()) {
-            builder.CreateBr(labels[labelName]);
-            
-            // Create unreachable block for any code after goto
-            currentBlock = BasicBlock::Create(ctx, "aftergoto", currentFunc);
-            builder.SetInsertPoint(currentBlock);
+        auto target = labels.find(labelName);
+        if (target != labels.end()) builder.CreateBr(target->second);
+    }
+    
+    // A bare `return`, also emitted when control reaches the end of a function: nothing for void,
+    // otherwise the zero of the return type (a null string, '\0' for char)
+    void createDefaultReturn() {
+        Type* returnType = currentFunc->getReturnType();
+        if (returnType->isVoidTy()) {
+            builder.CreateRetVoid();
+        } else {
+            builder.CreateRet(Constant::getNullValue(returnType));
         }
     }
     
@@ -728,15 +985,7 @@ public:
         FunctionInfo& funcInfo = functions[currentFunc->getName().str()];
         
         if (stmt == "return") {
-            if (funcInfo.returnType == VarType::VOID) {
-                builder.CreateRetVoid();
-            } else if (funcInfo.returnType == VarType::FLOAT) {
-                builder.CreateRet(ConstantFP::get(floatTy, 0.0));
-            } else if (funcInfo.returnType == VarType::DOUBLE) {
-                builder.CreateRet(ConstantFP::get(doubleTy, 0.0));
-            } else {
-                builder.CreateRet(ConstantInt::get(int32Ty, 0));
-            }
+            createDefaultReturn();
         } else {
             string retVal = stmt.substr(7);
             retVal.erase(0, retVal.find_first_not_of(" \t"));
@@ -769,179 +1018,684 @@ public:
         return {ConstantInt::get(int32Ty, 0), VarType::INT};
     }
     
+    void processPrint(const vector<string>& args) {
+        vector<PrintPiece> pieces;
+        for (const string& arg : args) {
+            if (arg.size() >= 2 && arg[0] == '"' && arg.back() == '"') {
+                pieces.push_back({processEscapes(arg.substr(1, arg.size() - 2))});
+            } else if (arg.size() >= 3 && arg[0] == '\'' && arg.back() == '\'') {
+                pieces.push_back({string(1, arg[1])});
+            } else {
+                pieces.push_back({"", getValueWithType(arg).first});
+            }
+        }
+        printer->emit(builder, pieces);
+    }
+    
     Value* processFunctionCall(const string& stmt) {
-
         size_t callPos = stmt.find("call ");
-            string rest = stmt.substr(callPos + 5);
-            
-            size_t parenPos = rest.find('(');
-            string funcName = rest.substr(0, parenPos);
-            
-            size_t endParen = rest.find(')');
-            string argsStr = rest.substr(parenPos + 1, endParen - parenPos - 1);
-            
-            // Handle print specially
-            if (funcName == "print") {
-                argsStr.erase(0, argsStr.find_first_not_of(" \t"));
-                argsStr.erase(argsStr.find_last_not_of(" \t") + 1);
+        string rest = stmt.substr(callPos + 5);
+        
+        size_t parenPos = rest.find('(');
+        string funcName = rest.substr(0, parenPos);
+        
+        // The call is the rest of the line, so its closing paren is the last one
+        size_t endParen = rest.rfind(')');
+        vector<string> args = splitTACArguments(rest.substr(parenPos + 1, endParen - parenPos - 1));
+        
+        if (funcName == "print") {
+            processPrint(args);
+            return nullptr;
+        }
+        
+        // Regular function call
+        if (functions.find(funcName) != functions.end()) {
+            FunctionInfo& info = functions[funcName];
+            vector<Value*> values;
+            for (size_t i = 0; i < args.size(); i++) {
+                auto [val, type] = getValueWithType(args[i]);
                 
-                if (argsStr[0] == '"') {
-                    // String literal - process escape sequences and print everything
-                    string str = argsStr.substr(1, argsStr.size() - 2);
-                    
-                    // Process escape sequences: convert \n to actual newline, etc.
-                    string processedStr;
-                    for (size_t i = 0; i < str.length(); i++) {
-                        if (str[i] == '\\' && i + 1 < str.length()) {
-                            switch (str[i + 1]) {
-                                case 'n': processedStr += '\n'; i++; break;
-                                case 't': processedStr += '\t'; i++; break;
-                                case 'r': processedStr += '\r'; i++; break;
-                                case '\\': processedStr += '\\'; i++; break;
-                                case '"': processedStr += '"'; i++; break;
-                                case '0': processedStr += '\0'; i++; break;
-                                default: 
-                                    // Keep backslash and next char as-is for unknown sequences
-                                    processedStr += str[i];
-                                    processedStr += str[i + 1];
-                                    i++;
-                                    break;
-                            }
-                        } else {
-                            processedStr += str[i];
-                        }
-                    }
-                    
-                    // Use printf to print the string - this will show all characters
-                    // including special ones like = + - etc., and escape sequences 
-                    // will already be converted to actual characters (newline, tab, etc.)
-                    Value* strVal = builder.CreateGlobalString(processedStr);
-                    Value* fmtStr = builder.CreateGlobalString("%s");
-                    builder.CreateCall(printfFunc, {fmtStr, strVal});
-                } else if (argsStr[0] == '\'' && argsStr.size() >= 3) {
-                    // Char literal - print without newline
-                    char ch = argsStr[1];
-                    builder.CreateCall(putcharFunc, {ConstantInt::get(int32Ty, ch)});
-                    // Removed the automatic newline
-                } else {
-                    // Variable or expression
-                    auto [val, type] = getValueWithType(argsStr);
-                    Type* valType = val->getType();
-                    
-                    // Check if it's a string variable (pointer type and VarType::STRING)
-                    if (type == VarType::STRING && valType->isPointerTy()) {
-                        // String variable - use printf with %s instead of puts
-                        Value* fmtStr = builder.CreateGlobalString("%s");
-                        builder.CreateCall(printfFunc, {fmtStr, val});
-                    } else if (valType->isFloatingPointTy()) {
-                        // Float or double - no newline in format
-                        Value* fmtStr = builder.CreateGlobalString("%f");
-                        if (valType->isFloatTy()) {
-                            val = builder.CreateFPExt(val, doubleTy);
-                        }
-                        builder.CreateCall(printfFunc, {fmtStr, val});
-                    } else if (valType->isIntegerTy(8)) {
-                        // Char - print without newline
-                        Value* charVal = builder.CreateZExt(val, int32Ty);
-                        builder.CreateCall(putcharFunc, {charVal});
-                    } else {
-                        // Integer - no newline in format
-                        if (valType->isIntegerTy(1)) {
-                            val = builder.CreateZExt(val, int32Ty);
-                        }
-                        Value* fmtStr = builder.CreateGlobalString("%d");
-                        builder.CreateCall(printfFunc, {fmtStr, val});
-                    }
+                // Convert to expected parameter type
+                if (i < info.paramTypes.size()) {
+                    val = convertToType(val, info.paramTypes[i]);
                 }
-                return nullptr;
+                values.push_back(val);
             }
-            
-            // Regular function call
-            if (functions.find(funcName) != functions.end()) {
-                vector<Value*> args;
-                
-                if (!argsStr.empty()) {
-                    stringstream ss(argsStr);
-                    string arg;
-                    size_t paramIdx = 0;
-                    
-                    while (getline(ss, arg, ',')) {
-                        arg.erase(0, arg.find_first_not_of(" \t"));
-                        arg.erase(arg.find_last_not_of(" \t") + 1);
-                        
-                        auto [val, type] = getValueWithType(arg);
-                        
-                        // Convert to expected parameter type
-                        if (paramIdx < functions[funcName].paramTypes.size()) {
-                            VarType expectedType = functions[funcName].paramTypes[paramIdx];
-                            val = convertToType(val, expectedType);
-                        }
-                        
-                        args.push_back(val);
-                        paramIdx++;
-                    }
+            return builder.CreateCall(info.func, values);
+        }
+        
+        return nullptr;
+    }
+    
+    string extractFunctionName(const string& line) {
+        size_t start = line.find("function ") + 9;
+        size_t end = line.find(" ", start);
+        return line.substr(start, end - start);
+    }
+};
+
+// === Module Back End ===
+// Everything after lowering is shared by the TAC and AST backends.
+
+static bool verifyLoweredModule(Module& module) {
+    PhaseTimer timer("verify");
+    string errStr;
+    raw_string_ostream errStream(errStr);
+    if (verifyModule(module, &errStream)) {
+        errs() << "Module verification failed:\n" << errStr << "\n";
+        return false;
+    }
+    return true;
+}
+
+// Every local lives in an entry-block alloca, so even -O0 runs mem2reg: loop
+// variables become SSA registers and phis for a negligible compile-time cost
+static void promoteAllocas(Module& module) {
+    PhaseTimer timer("mem2reg");
+    FunctionAnalysisManager fam;
+    PassBuilder pb;
+    pb.registerFunctionAnalyses(fam);
+    
+    FunctionPassManager fpm;
+    fpm.addPass(PromotePass());
+    for (Function& f : module) {
+        if (!f.isDeclaration()) {
+            fpm.run(f, fam);
+        }
+    }
+}
+
+// Runs the new PassManager's default per-module pipeline (mem2reg/SROA, instcombine, GVN,
+// loop passes, inlining, ...). The host TargetMachine is handed to the PassBuilder so
+// cost models see the real target, and the module is stamped with its layout up front.
+static void optimizeModule(Module& module, int level) {
+    PhaseTimer timer("optimize");
+    InitializeNativeTarget();
+    InitializeNativeTargetAsmPrinter();
+    
+    unique_ptr<TargetMachine> tm;
+    if (auto jtmb = orc::JITTargetMachineBuilder::detectHost()) {
+        if (auto created = jtmb->createTargetMachine()) {
+            tm = std::move(*created);
+            module.setTargetTriple(tm->getTargetTriple().str());
+            module.setDataLayout(tm->createDataLayout());
+        } else {
+            consumeError(created.takeError());
+        }
+    } else {
+        consumeError(jtmb.takeError());
+    }
+    
+    LoopAnalysisManager lam;
+    FunctionAnalysisManager fam;
+    CGSCCAnalysisManager cgam;
+    ModuleAnalysisManager mam;
+    
+    PassBuilder pb(tm.get());
+    pb.registerModuleAnalyses(mam);
+    pb.registerCGSCCAnalyses(cgam);
+    pb.registerFunctionAnalyses(fam);
+    pb.registerLoopAnalyses(lam);
+    pb.crossRegisterProxies(lam, fam, cgam, mam);
+    
+    OptimizationLevel pipelineLevel = level == 1 ? OptimizationLevel::O1
+                                    : level == 2 ? OptimizationLevel::O2
+                                    : OptimizationLevel::O3;
+    ModulePassManager mpm = pb.buildPerModuleDefaultPipeline(pipelineLevel);
+    mpm.run(module, mam);
+}
+
+
+// Erases every function main cannot reach through calls (for the TAC backend, also those
+// whose calls were all inlined), so they cost no verification, optimization or JIT time.
+// A module without main is left alone.
+static void removeUnreferencedFunctions(Module& module) {
+    Function* mainFunc = module.getFunction("main");
+    if (!mainFunc) return;
+    
+    SmallPtrSet<Function*, 32> live;
+    SmallVector<Function*, 32> work;
+    live.insert(mainFunc);
+    work.push_back(mainFunc);
+    while (!work.empty()) {
+        Function* func = work.pop_back_val();
+        for (Instruction& inst : instructions(*func)) {
+            for (Value* operand : inst.operands()) {
+                if (auto callee = dyn_cast<Function>(operand->stripPointerCasts())) {
+                    if (live.insert(callee).second) work.push_back(callee);
                 }
-                
-                return builder.CreateCall(functions[funcName].func, args);
             }
-            
-            return nullptr;
+        }
+    }
+    
+    vector<Function*> dead;
+    for (Function& func : module) {
+        if (!live.count(&func)) dead.push_back(&func);
+    }
+    for (Function* func : dead) func->dropAllReferences();
+    for (Function* func : dead) func->eraseFromParent();
+}
+
+// Verification plus the -O pipeline; throws when the module is malformed
+static void finishModule(Module& module) {
+    removeUnreferencedFunctions(module);
+    if (!verifyLoweredModule(module)) {
+        if (!compilerOptions.quiet) {
+            module.print(errs(), nullptr);
+        }
+        throw CompilationError("LLVM module verification failed");
+    }
+    if (compilerOptions.optLevel > 0) {
+        optimizeModule(module, compilerOptions.optLevel);
+    } else {
+        promoteAllocas(module);
+    }
+}
+
+static size_t instructionCount(const Module& module) {
+    size_t count = 0;
+    for (const Function& f : module) {
+        count += f.getInstructionCount();
+    }
+    return count;
+}
+
+// Ahead-of-time code generation for the default target triple. The object is
+// position independent so the system linker can produce a PIE from it.
+static bool emitObjectFile(Module& module, const string& filename) {
+    PhaseTimer timer("emit-object");
+    InitializeNativeTarget();
+    InitializeNativeTargetAsmPrinter();
+    
+    string triple = sys::getDefaultTargetTriple();
+    string err;
+    const Target* target = TargetRegistry::lookupTarget(triple, err);
+    if (!target) {
+        errs() << "Error: " << err << "\n";
+        return false;
+    }
+    
+    CodeGenOpt::Level codegenLevel = compilerOptions.optLevel == 0 ? CodeGenOpt::None
+                                   : compilerOptions.optLevel == 1 ? CodeGenOpt::Less
+                                   : compilerOptions.optLevel == 2 ? CodeGenOpt::Default
+                                   : CodeGenOpt::Aggressive;
+    unique_ptr<TargetMachine> tm(target->createTargetMachine(
+        triple, "generic", "", TargetOptions(), Reloc::PIC_, None, codegenLevel));
+    if (!tm) {
+        errs() << "Error: Cannot create target machine for " << triple << "\n";
+        return false;
+    }
+    module.setTargetTriple(triple);
+    module.setDataLayout(tm->createDataLayout());
+    
+    error_code ec;
+    raw_fd_ostream out(filename, ec, sys::fs::OF_None);
+    if (ec) {
+        errs() << "Error: Cannot write object file " << filename << ": " << ec.message() << "\n";
+        return false;
+    }
+    
+    legacy::PassManager pm;
+    if (tm->addPassesToEmitFile(pm, out, nullptr, CGFT_ObjectFile)) {
+        errs() << "Error: Target cannot emit object files\n";
+        return false;
+    }
+    pm.run(module);
+    out.flush();
+    return true;
+}
+
+
+// With a cache key the module is compiled eagerly and in one piece, so the whole
+// program lands in the object cache under that key
+static bool runLoweredProgram(LoweredProgram& program, const string& cacheKey, RunStats& stats) {
+    if (!compilerOptions.quiet) {
+        outs() << "\033[1m\033[95m========== EXECUTING PROGRAM ==========\033[0m\n";
+    }
+    
+    if (!program.module->getFunction("main")) {
+        errs() << "Error: No main function found\n";
+        return false;
+    }
+    
+    auto jitStart = chrono::steady_clock::now();
+    unique_ptr<DiskObjectCache> cache;
+    unique_ptr<orc::LLJIT> jit;
+    {
+        PhaseTimer timer("jit-setup");
+        bool lazy = compilerOptions.lazyJIT && cacheKey.empty();
+        if (!cacheKey.empty()) {
+            cache = make_unique<DiskObjectCache>(compilerOptions.cacheDir);
+            program.module->setModuleIdentifier(cacheKey);
         }
         
-        string extractFunctionName(const string& line) {
-            size_t start = line.find("function ") + 9;
-            size_t end = line.find(" ", start);
-            return line.substr(start, end - start);
+        // Lazily, every function sits behind a compile-on-demand stub and is compiled on
+        // its first call, so functions that never run are never compiled. Eagerly
+        // (--eager-jit) the whole module is compiled when main is looked up.
+        jit = createHostJIT(lazy, cache.get());
+        if (!jit) {
+            return false;
         }
         
-        void printIR() {
-            outs() << "\n========== GENERATED LLVM IR ==========\n";
-            module->print(outs(), nullptr);
-            outs() << "=======================================\n\n";
+        program.module->setDataLayout(jit->getDataLayout());
+        orc::ThreadSafeModule tsm(std::move(program.module), orc::ThreadSafeContext(std::move(program.context)));
+        Error err = lazy
+            ? static_cast<orc::LLLazyJIT&>(*jit).addLazyIRModule(std::move(tsm))
+            : jit->addIRModule(std::move(tsm));
+        if (err) {
+            errs() << "JIT Error: " << toString(std::move(err)) << "\n";
+            return false;
+        }
+    }
+    return runJITMain(*jit, program.mainReturnsVoid, jitStart, stats);
+}
+
+RunStats executeLoweredProgram(LoweredProgram program, const string& cacheKey,
+                               chrono::steady_clock::time_point buildStart) {
+    RunStats stats;
+    finishModule(*program.module);
+    stats.buildMs = chrono::duration<double, milli>(chrono::steady_clock::now() - buildStart).count();
+    
+    if (!compilerOptions.quiet) {
+        outs() << "\n========== GENERATED LLVM IR ==========\n";
+        program.module->print(outs(), nullptr);
+        outs() << "=======================================\n\n";
+    }
+    if (!runLoweredProgram(program, cacheKey, stats)) {
+        throw CompilationError("cannot run program");
+    }
+    return stats;
+}
+
+size_t writeLoweredIR(LoweredProgram& program, const string& irFile) {
+    finishModule(*program.module);
+    
+    error_code ec;
+    raw_fd_ostream out(irFile, ec, sys::fs::OF_Text);
+    if (ec) {
+        errs() << "Error: Cannot write IR file " << irFile << ": " << ec.message() << "\n";
+        throw CompilationError("cannot write " + irFile);
+    }
+    program.module->print(out, nullptr);
+    return instructionCount(*program.module);
+}
+
+// === Native Runtime ===
+// Executables do not link runtime.cpp, so the buffered runtime it implements is defined in the
+// module as IR: a 64 KB module-private buffer that reaches fd 1 through write(2) when it fills
+// up and once main returns. Integers are formatted inline; only %f goes through snprintf.
+class NativeRuntimeBuilder {
+private:
+    static constexpr uint64_t capacity = 1 << 16;
+    
+    Module& module;
+    LLVMContext& ctx;
+    Type* voidTy;
+    IntegerType* int8Ty;
+    IntegerType* int32Ty;
+    IntegerType* sizeTy;
+    PointerType* bytePtrTy;
+    ArrayType* bufferTy;
+    GlobalVariable* buffer;
+    GlobalVariable* used;
+    Function* writeAll;
+    Function* flush;
+    Function* append;
+    
+    // Internal definition of `name`, taking over the declaration the print lowering made
+    Function* define(const char* name, Type* result, ArrayRef<Type*> params) {
+        Function* func = module.getFunction(name);
+        if (!func) {
+            func = Function::Create(FunctionType::get(result, params, false), Function::InternalLinkage, name, module);
         }
+        func->setLinkage(GlobalValue::InternalLinkage);
+        return func;
+    }
+    
+    Value* bufferAt(IRBuilder<>& builder, Value* offset) {
+        return builder.CreateInBoundsGEP(bufferTy, buffer, {ConstantInt::get(sizeTy, 0), offset});
+    }
+    
+    // write(2) until every byte is out or it fails
+    void defineWriteAll() {
+        writeAll = define("__rt_write_all", voidTy, {bytePtrTy, sizeTy});
+        FunctionCallee writeFunc = module.getOrInsertFunction(
+            "write", FunctionType::get(sizeTy, {int32Ty, bytePtrTy, sizeTy}, false));
+        BasicBlock* entry = BasicBlock::Create(ctx, "entry", writeAll);
+        BasicBlock* loop = BasicBlock::Create(ctx, "loop", writeAll);
+        BasicBlock* body = BasicBlock::Create(ctx, "body", writeAll);
+        BasicBlock* done = BasicBlock::Create(ctx, "done", writeAll);
+        IRBuilder<> builder(entry);
+        builder.CreateBr(loop);
         
-        void run() {
-            outs() << "\033[1m\033[95m========== EXECUTING PROGRAM ==========\033[0m\n";
-            
-            InitializeNativeTarget();
-            InitializeNativeTargetAsmPrinter();
-            InitializeNativeTargetAsmParser();
-            
-            string err;
-            ExecutionEngine* ee = EngineBuilder(std::move(module)).setErrorStr(&err).create();
-            
-            if (!ee) {
-                errs() << "Engine Error: " << err << "\n";
-                return;
-            }
-            
-            ee->finalizeObject();
-            
-            if (functions.find("main") != functions.end()) {
-                Function* mainFunc = functions["main"].func;
-                ee->runFunction(mainFunc, {});
-            } 
-            else {
-                errs() << "Error: No main function found\n";
-            }
-            
-            outs() << "=======================================\n";
-            
-            delete ee;
+        builder.SetInsertPoint(loop);
+        PHINode* data = builder.CreatePHI(bytePtrTy, 2);
+        PHINode* remaining = builder.CreatePHI(sizeTy, 2);
+        data->addIncoming(writeAll->getArg(0), entry);
+        remaining->addIncoming(writeAll->getArg(1), entry);
+        builder.CreateCondBr(builder.CreateICmpEQ(remaining, ConstantInt::get(sizeTy, 0)), done, body);
+        
+        builder.SetInsertPoint(body);
+        Value* written = builder.CreateCall(writeFunc, {ConstantInt::get(int32Ty, 1), data, remaining});
+        data->addIncoming(builder.CreateInBoundsGEP(int8Ty, data, written), body);
+        remaining->addIncoming(builder.CreateSub(remaining, written), body);
+        builder.CreateCondBr(builder.CreateICmpSGT(written, ConstantInt::get(sizeTy, 0)), loop, done);
+        
+        builder.SetInsertPoint(done);
+        builder.CreateRetVoid();
+    }
+    
+    void defineFlush() {
+        flush = define("__rt_flush", voidTy, {});
+        BasicBlock* entry = BasicBlock::Create(ctx, "entry", flush);
+        BasicBlock* write = BasicBlock::Create(ctx, "write", flush);
+        BasicBlock* done = BasicBlock::Create(ctx, "done", flush);
+        IRBuilder<> builder(entry);
+        Value* count = builder.CreateLoad(sizeTy, used);
+        builder.CreateCondBr(builder.CreateICmpEQ(count, ConstantInt::get(sizeTy, 0)), done, write);
+        
+        builder.SetInsertPoint(write);
+        builder.CreateCall(writeAll, {bufferAt(builder, ConstantInt::get(sizeTy, 0)), count});
+        builder.CreateStore(ConstantInt::get(sizeTy, 0), used);
+        builder.CreateBr(done);
+        
+        builder.SetInsertPoint(done);
+        builder.CreateRetVoid();
+    }
+    
+    // Copies into the buffer, flushing first when it would overflow; text larger than the
+    // whole buffer is written straight through
+    void defineAppend() {
+        append = define("__rt_append", voidTy, {bytePtrTy, sizeTy});
+        Value* data = append->getArg(0);
+        Value* length = append->getArg(1);
+        BasicBlock* entry = BasicBlock::Create(ctx, "entry", append);
+        BasicBlock* full = BasicBlock::Create(ctx, "full", append);
+        BasicBlock* direct = BasicBlock::Create(ctx, "direct", append);
+        BasicBlock* copy = BasicBlock::Create(ctx, "copy", append);
+        IRBuilder<> builder(entry);
+        Value* offset = builder.CreateLoad(sizeTy, used);
+        Value* fits = builder.CreateICmpULE(builder.CreateAdd(offset, length), ConstantInt::get(sizeTy, capacity));
+        builder.CreateCondBr(fits, copy, full);
+        
+        builder.SetInsertPoint(full);
+        builder.CreateCall(flush);
+        builder.CreateCondBr(builder.CreateICmpUGT(length, ConstantInt::get(sizeTy, capacity)), direct, copy);
+        
+        builder.SetInsertPoint(direct);
+        builder.CreateCall(writeAll, {data, length});
+        builder.CreateRetVoid();
+        
+        builder.SetInsertPoint(copy);
+        PHINode* start = builder.CreatePHI(sizeTy, 2);
+        start->addIncoming(offset, entry);
+        start->addIncoming(ConstantInt::get(sizeTy, 0), full);
+        builder.CreateMemCpy(bufferAt(builder, start), MaybeAlign(1), data, MaybeAlign(1), length);
+        builder.CreateStore(builder.CreateAdd(start, length), used);
+        builder.CreateRetVoid();
+    }
+    
+    // Digits are produced back to front; the magnitude is unsigned so INT32_MIN works
+    void definePrintInt() {
+        Function* func = define("__rt_print_int", voidTy, {int32Ty});
+        Value* value = func->getArg(0);
+        const uint64_t width = 12;
+        ArrayType* digitsTy = ArrayType::get(int8Ty, width);
+        BasicBlock* entry = BasicBlock::Create(ctx, "entry", func);
+        BasicBlock* loop = BasicBlock::Create(ctx, "loop", func);
+        BasicBlock* sign = BasicBlock::Create(ctx, "sign", func);
+        BasicBlock* minus = BasicBlock::Create(ctx, "minus", func);
+        BasicBlock* done = BasicBlock::Create(ctx, "done", func);
+        IRBuilder<> builder(entry);
+        Value* digits = builder.CreateAlloca(digitsTy);
+        Value* negative = builder.CreateICmpSLT(value, ConstantInt::get(int32Ty, 0));
+        Value* magnitude = builder.CreateSelect(negative, builder.CreateNeg(value), value);
+        builder.CreateBr(loop);
+        
+        auto digitAt = [&](Value* index) {
+            return builder.CreateInBoundsGEP(digitsTy, digits, {ConstantInt::get(sizeTy, 0), index});
+        };
+        builder.SetInsertPoint(loop);
+        PHINode* index = builder.CreatePHI(sizeTy, 2);
+        PHINode* rest = builder.CreatePHI(int32Ty, 2);
+        index->addIncoming(ConstantInt::get(sizeTy, width), entry);
+        rest->addIncoming(magnitude, entry);
+        Value* next = builder.CreateSub(index, ConstantInt::get(sizeTy, 1));
+        Value* digit = builder.CreateTrunc(builder.CreateURem(rest, ConstantInt::get(int32Ty, 10)), int8Ty);
+        builder.CreateStore(builder.CreateAdd(digit, ConstantInt::get(int8Ty, '0')), digitAt(next));
+        Value* quotient = builder.CreateUDiv(rest, ConstantInt::get(int32Ty, 10));
+        index->addIncoming(next, loop);
+        rest->addIncoming(quotient, loop);
+        builder.CreateCondBr(builder.CreateICmpNE(quotient, ConstantInt::get(int32Ty, 0)), loop, sign);
+        
+        builder.SetInsertPoint(sign);
+        builder.CreateCondBr(negative, minus, done);
+        
+        builder.SetInsertPoint(minus);
+        Value* signIndex = builder.CreateSub(next, ConstantInt::get(sizeTy, 1));
+        builder.CreateStore(ConstantInt::get(int8Ty, '-'), digitAt(signIndex));
+        builder.CreateBr(done);
+        
+        builder.SetInsertPoint(done);
+        PHINode* first = builder.CreatePHI(sizeTy, 2);
+        first->addIncoming(next, sign);
+        first->addIncoming(signIndex, minus);
+        builder.CreateCall(append, {digitAt(first), builder.CreateSub(ConstantInt::get(sizeTy, width), first)});
+        builder.CreateRetVoid();
+    }
+    
+    // Same text as printf("%f")
+    void definePrintFloat() {
+        Function* func = define("__rt_print_float", voidTy, {Type::getDoubleTy(ctx)});
+        FunctionCallee snprintfFunc = module.getOrInsertFunction(
+            "snprintf", FunctionType::get(int32Ty, {bytePtrTy, sizeTy, bytePtrTy}, true));
+        const uint64_t size = 512;
+        ArrayType* textTy = ArrayType::get(int8Ty, size);
+        BasicBlock* entry = BasicBlock::Create(ctx, "entry", func);
+        BasicBlock* write = BasicBlock::Create(ctx, "write", func);
+        BasicBlock* done = BasicBlock::Create(ctx, "done", func);
+        IRBuilder<> builder(entry);
+        Value* text = builder.CreateInBoundsGEP(textTy, builder.CreateAlloca(textTy),
+                                                {ConstantInt::get(sizeTy, 0), ConstantInt::get(sizeTy, 0)});
+        Value* format = builder.CreateGlobalStringPtr("%f", ".fmt", 0, &module);
+        Value* length = builder.CreateCall(snprintfFunc, {text, ConstantInt::get(sizeTy, size), format, func->getArg(0)});
+        builder.CreateCondBr(builder.CreateICmpSGT(length, ConstantInt::get(int32Ty, 0)), write, done);
+        
+        builder.SetInsertPoint(write);
+        Value* wide = builder.CreateZExt(length, sizeTy);
+        Value* limit = ConstantInt::get(sizeTy, size - 1);
+        builder.CreateCall(append, {text, builder.CreateSelect(builder.CreateICmpULT(wide, limit), wide, limit)});
+        builder.CreateBr(done);
+        
+        builder.SetInsertPoint(done);
+        builder.CreateRetVoid();
+    }
+    
+    void definePrintStr() {
+        Function* func = define("__rt_print_str", voidTy, {bytePtrTy});
+        FunctionCallee strlenFunc = module.getOrInsertFunction("strlen", FunctionType::get(sizeTy, {bytePtrTy}, false));
+        Value* text = func->getArg(0);
+        BasicBlock* entry = BasicBlock::Create(ctx, "entry", func);
+        BasicBlock* write = BasicBlock::Create(ctx, "write", func);
+        BasicBlock* done = BasicBlock::Create(ctx, "done", func);
+        IRBuilder<> builder(entry);
+        builder.CreateCondBr(builder.CreateIsNull(text), done, write);
+        
+        builder.SetInsertPoint(write);
+        builder.CreateCall(append, {text, builder.CreateCall(strlenFunc, {text})});
+        builder.CreateBr(done);
+        
+        builder.SetInsertPoint(done);
+        builder.CreateRetVoid();
+    }
+    
+    void definePrintChar() {
+        Function* func = define("__rt_print_char", voidTy, {int32Ty});
+        BasicBlock* entry = BasicBlock::Create(ctx, "entry", func);
+        BasicBlock* full = BasicBlock::Create(ctx, "full", func);
+        BasicBlock* store = BasicBlock::Create(ctx, "store", func);
+        IRBuilder<> builder(entry);
+        Value* offset = builder.CreateLoad(sizeTy, used);
+        builder.CreateCondBr(builder.CreateICmpEQ(offset, ConstantInt::get(sizeTy, capacity)), full, store);
+        
+        builder.SetInsertPoint(full);
+        builder.CreateCall(flush);
+        builder.CreateBr(store);
+        
+        builder.SetInsertPoint(store);
+        PHINode* slot = builder.CreatePHI(sizeTy, 2);
+        slot->addIncoming(offset, entry);
+        slot->addIncoming(ConstantInt::get(sizeTy, 0), full);
+        builder.CreateStore(builder.CreateTrunc(func->getArg(0), int8Ty), bufferAt(builder, slot));
+        builder.CreateStore(builder.CreateAdd(slot, ConstantInt::get(sizeTy, 1)), used);
+        builder.CreateRetVoid();
+    }
+    
+    // The program's main becomes internal and a new main runs it, then flushes the buffer.
+    // A void main exits with status 0, as it does under the JIT.
+    void wrapMain() {
+        Function* programMain = module.getFunction("main");
+        if (!programMain || programMain->isDeclaration() || programMain->arg_size() != 0) return;
+        programMain->setName("__rt_program_main");
+        programMain->setLinkage(GlobalValue::InternalLinkage);
+        
+        Function* entryMain = Function::Create(FunctionType::get(int32Ty, {}, false),
+                                               Function::ExternalLinkage, "main", module);
+        IRBuilder<> builder(BasicBlock::Create(ctx, "entry", entryMain));
+        Value* result = builder.CreateCall(programMain);
+        builder.CreateCall(flush);
+        builder.CreateRet(result->getType() == int32Ty ? result : ConstantInt::get(int32Ty, 0));
+    }
+    
+public:
+    explicit NativeRuntimeBuilder(Module& m) : module(m), ctx(m.getContext()) {
+        voidTy = Type::getVoidTy(ctx);
+        int8Ty = Type::getInt8Ty(ctx);
+        int32Ty = Type::getInt32Ty(ctx);
+        sizeTy = IntegerType::get(ctx, sizeof(size_t) * 8);
+        bytePtrTy = PointerType::getUnqual(int8Ty);
+        bufferTy = ArrayType::get(int8Ty, capacity);
+        buffer = new GlobalVariable(module, bufferTy, false, GlobalValue::InternalLinkage,
+                                    ConstantAggregateZero::get(bufferTy), "__rt_buffer");
+        used = new GlobalVariable(module, sizeTy, false, GlobalValue::InternalLinkage,
+                                  ConstantInt::get(sizeTy, 0), "__rt_used");
+    }
+    
+    // Entry points the program never calls are left to removeUnreferencedFunctions
+    void build() {
+        defineWriteAll();
+        defineFlush();
+        defineAppend();
+        definePrintInt();
+        definePrintFloat();
+        definePrintStr();
+        definePrintChar();
+        wrapMain();
+    }
+};
+
+// Writes a native object file, or an executable when `link` is set. The executable is linked
+// by the system C compiler ($CC, default cc) against libc only; no LLVM is needed to run it.
+void emitLoweredNative(LoweredProgram& program, const string& outputFile, bool link) {
+    NativeRuntimeBuilder(*program.module).build();
+    finishModule(*program.module);
+    
+    string objectFile = link ? outputFile + ".o" : outputFile;
+    if (!emitObjectFile(*program.module, objectFile)) {
+        throw CompilationError("cannot emit " + objectFile);
+    }
+    
+    if (link) {
+        PhaseTimer timer("link");
+        const char* cc = getenv("CC");
+        string command = string(cc && *cc ? cc : "cc") + " \"" + objectFile + "\" -o \"" + outputFile + "\"";
+        int status = system(command.c_str());
+        remove(objectFile.c_str());
+        if (status != 0) {
+            cerr << "Error: Link command failed: " << command << endl;
+            throw CompilationError("cannot link " + outputFile);
         }
-    };
+    }
+    
+    if (!compilerOptions.quiet) {
+        cout << "Wrote " << (link ? "executable" : "object file") << ": " << outputFile << endl;
+    }
+}
+
+// === TAC Backend Entry Points ===
 
-void executeTACProgram() {
+static LoweredProgram lowerTACFile(const string& tacFile) {
     TACExecutor executor;
-    const string tacFile = "tester/tac.txt";
     if (!executor.readTACFile(tacFile)) {
         std::cerr << "Error: Failed to read TAC file: " << tacFile << std::endl;
-        exit(1);
+        throw CompilationError("cannot read " + tacFile);
+    }
+    return executor.lower();
+}
+
+RunStats executeTACProgram(const string& tacFile, const string& cacheKey) {
+    if (!compilerOptions.quiet) {
+        cout << "Reading TAC from: " << tacFile << std::endl;
+    }
+    auto buildStart = chrono::steady_clock::now();
+    return executeLoweredProgram(lowerTACFile(tacFile), cacheKey, buildStart);
+}
+
+void emitNativeProgram(const string& tacFile, const string& outputFile, bool link) {
+    LoweredProgram program = lowerTACFile(tacFile);
+    emitLoweredNative(program, outputFile, link);
+}
+
+// Builds and verifies the module without running it; used by batch mode and the benchmarks
+size_t compileTACToIR(const string& tacFile, const string& irFile) {
+    LoweredProgram program = lowerTACFile(tacFile);
+    return writeLoweredIR(program, irFile);
+}
+
+// === Compilation Cache ===
+
+// SHA-1 over everything that decides the generated code: the source text, the flags that change
+// codegen, the LLVM version and host, and this compiler's own build
+string compilationCacheKey(const string& sourceFile) {
+    auto source = MemoryBuffer::getFile(sourceFile);
+    if (!source) {
+        return "";
+    }
+    SHA1 hasher;
+    hasher.update((*source)->getBuffer());
+    hasher.update("|-O" + to_string(compilerOptions.optLevel));
+    hasher.update(compilerOptions.backend == Backend::AST ? "|ast" : "|tac");
+    hasher.update(compilerOptions.optimizeTAC ? "|tac-opt" : "|no-tac-opt");
+    hasher.update("|" LLVM_VERSION_STRING "|" + sys::getProcessTriple() + "|" + sys::getHostCPUName().str());
+    hasher.update("|" __DATE__ " " __TIME__);
+    return toHex(hasher.final(), true);
+}
+
+bool runCachedProgram(const string& cacheKey, RunStats& stats) {
+    string path = compilerOptions.cacheDir + "/" + cacheKey + ".o";
+    auto object = MemoryBuffer::getFile(path);
+    if (!object) {
+        return false;
     }
     
-    cout << "Reading TAC from: " << tacFile << std::endl;
+    if (!compilerOptions.quiet) {
+        cout << "Using cached object: " << path << std::endl;
+        outs() << "\033[1m\033[95m========== EXECUTING PROGRAM ==========\033[0m\n";
+    }
     
-    executor.execute();
-    executor.printIR();
-    executor.run();
-}
\ No newline at end of file
+    auto jitStart = chrono::steady_clock::now();
+    unique_ptr<orc::LLJIT> jit;
+    {
+        PhaseTimer timer("jit-setup");
+        jit = createHostJIT(false, nullptr);
+        if (!jit) {
+            return false;
+        }
+        if (Error err = jit->addObjectFile(std::move(*object))) {
+            errs() << "JIT Error: " << toString(std::move(err)) << "\n";
+            return false;
+        }
+    }
+    // Source mains always return int (a void main only exists in hand-written TAC)
+    return runJITMain(*jit, false, jitStart, stats);
+}
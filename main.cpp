@@ -1,24 +1,165 @@
 #include "compiler.h"
 #include <chrono>
 
+static void printUsage(const char* prog) {
+    cerr << "Usage: " << prog << " [name]                       compile and run tester/<name>.txt\n"
+         << "       " << prog << " --batch [-j N] [-o dir] inputs...\n"
+         << "             inputs are files, directories, wildcards (\"tester/*.txt\") or @listfiles\n"
+         << "Options:\n"
+         << "  -O0 | -O1 | -O2 | -O3      LLVM optimization level applied before running (default -O0)\n"
+         << "  --emit-obj <file>          write a native object file instead of running the program\n"
+         << "  --emit-exe <file>          write a native executable (linked with $CC or cc) instead of running\n"
+         << "  --cache-dir <dir>          reuse compiled objects of unchanged programs from <dir>\n"
+         << "  --backend tac|ast|interp   lower through TAC text (default) or straight from the AST,\n"
+         << "                             or interpret the TAC without LLVM (starts instantly)\n"
+         << "  --dump-tac                 with --backend ast, still write tester/tac.txt\n"
+         << "  --no-tac-opt               write TAC as generated, without folding and dead code removal\n"
+         << "  --eager-jit                compile the whole module before running main (default: lazy)\n"
+         << "  --time-report              print wall time, allocations and peak RSS per phase\n"
+         << "  --time-report-json <file>  also write the report as JSON\n"
+         << "  --trace <file>             write phase and per-function spans as Chrome trace JSON\n";
+}
+
+static int finish(int status, const string& timeReportJson, const string& traceFile) {
+    if (compilerOptions.timeReport) {
+        printTimeReport(cout);
+        if (!timeReportJson.empty() && !writeTimeReportJSON(timeReportJson)) {
+            return EXIT_FAILURE;
+        }
+    }
+    if (compilerOptions.trace && !writeTraceJSON(traceFile)) {
+        return EXIT_FAILURE;
+    }
+    return status;
+}
+
 int main(int argc, char* argv[]) {
     auto start = chrono::high_resolution_clock::now();
 
-    string fileName = (argc > 1) ? argv[1] : "sample";
+    string fileName = "sample";
+    bool batchMode = false;
+    unsigned jobs = 0;
+    string outputDir = "tester/batch";
+    string timeReportJson;
+    string traceFile;
+    string nativeOutput;
+    bool linkNative = false;
+    vector<string> batchInputs;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--batch") {
+            batchMode = true;
+        } else if ((arg == "-j" || arg == "-o") && i + 1 < argc) {
+            if (arg == "-j") {
+                string count = argv[++i];
+                if (count.empty() || count.size() > 6 || count.find_first_not_of("0123456789") != string::npos) {
+                    cerr << "Invalid job count: " << count << " (expected a number; 0 uses every core)\n";
+                    return EXIT_FAILURE;
+                }
+                jobs = stoul(count);
+            } else {
+                outputDir = argv[++i];
+            }
+        } else if (arg.size() == 3 && arg[0] == '-' && arg[1] == 'O' && arg[2] >= '0' && arg[2] <= '3') {
+            compilerOptions.optLevel = arg[2] - '0';
+        } else if ((arg == "--emit-obj" || arg == "--emit-exe") && i + 1 < argc) {
+            linkNative = arg == "--emit-exe";
+            nativeOutput = argv[++i];
+        } else if (arg == "--cache-dir" && i + 1 < argc) {
+            compilerOptions.cacheDir = argv[++i];
+        } else if (arg == "--backend" && i + 1 < argc) {
+            string backend = argv[++i];
+            if (backend != "tac" && backend != "ast" && backend != "interp") {
+                cerr << "Unknown backend: " << backend << " (expected tac, ast or interp)\n";
+                return EXIT_FAILURE;
+            }
+            compilerOptions.backend = backend == "ast" ? Backend::AST
+                                    : backend == "interp" ? Backend::INTERP : Backend::TAC;
+        } else if (arg == "--dump-tac") {
+            compilerOptions.dumpTAC = true;
+        } else if (arg == "--no-tac-opt") {
+            compilerOptions.optimizeTAC = false;
+        } else if (arg == "--eager-jit") {
+            compilerOptions.lazyJIT = false;
+        } else if (arg == "--time-report") {
+            compilerOptions.timeReport = true;
+        } else if (arg == "--time-report-json" && i + 1 < argc) {
+            compilerOptions.timeReport = true;
+            timeReportJson = argv[++i];
+        } else if (arg == "--trace" && i + 1 < argc) {
+            compilerOptions.trace = true;
+            traceFile = argv[++i];
+        } else if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (batchMode) {
+            batchInputs.push_back(arg);
+        } else {
+            fileName = arg;
+        }
+    }
+
+    // The interpreter only runs programs; it has no IR or objects to write
+    if (compilerOptions.backend == Backend::INTERP && (batchMode || !nativeOutput.empty())) {
+        cerr << "--backend interp cannot be combined with --batch, --emit-obj or --emit-exe\n";
+        return EXIT_FAILURE;
+    }
+
+    if (batchMode) {
+        return finish(runBatchCompilation(batchInputs, outputDir, jobs), timeReportJson, traceFile);
+    }
+
     string inputFile = "tester/" + fileName + ".txt";
     string tokenFile = "tester/tokens.txt";
-
-    vector<Token> tokens = lexAndDumpToFile(inputFile, tokenFile);
-
-    auto ast = parseFromFile(tokens);
-
-    performScopeAnalysis(ast, tokens);
-
-    performTypeChecking(ast, tokens);
-
-    generateTAC(ast, "tester/tac.txt");
-
-    executeTACProgram();
+    int exitCode = 0;
+    string cacheKey;
+
+    try {
+        // A cache hit skips everything from lexing through code generation
+        if (!compilerOptions.cacheDir.empty() && nativeOutput.empty() && compilerOptions.backend != Backend::INTERP) {
+            cacheKey = compilationCacheKey(inputFile);
+            RunStats cached;
+            if (!cacheKey.empty() && runCachedProgram(cacheKey, cached)) {
+                long long durationMs = chrono::duration_cast<chrono::milliseconds>(
+                    chrono::high_resolution_clock::now() - start).count();
+                cout << "\nTotal time: " << durationMs << " ms\n";
+                return finish(cached.exitCode, timeReportJson, traceFile);
+            }
+        }
+
+        vector<Token> tokens = lexAndDumpToFile(inputFile, tokenFile);
+
+        auto ast = parseFromFile(tokens);
+
+        performScopeAnalysis(ast, tokens);
+
+        performTypeChecking(ast, tokens);
+
+        if (compilerOptions.backend == Backend::AST) {
+            if (compilerOptions.dumpTAC) {
+                generateTAC(ast, "tester/tac.txt");
+            }
+            if (!nativeOutput.empty()) {
+                emitNativeProgramFromAST(ast, nativeOutput, linkNative);
+            } else {
+                exitCode = executeASTProgram(ast, cacheKey).exitCode;
+            }
+        } else if (compilerOptions.backend == Backend::INTERP) {
+            generateTAC(ast, "tester/tac.txt");
+            exitCode = interpretTACProgram("tester/tac.txt").exitCode;
+        } else {
+            generateTAC(ast, "tester/tac.txt");
+
+            if (!nativeOutput.empty()) {
+                emitNativeProgram("tester/tac.txt", nativeOutput, linkNative);
+            } else {
+                exitCode = executeTACProgram("tester/tac.txt", cacheKey).exitCode;
+            }
+        }
+    } catch (const CompilationError&) {
+        return finish(EXIT_FAILURE, timeReportJson, traceFile);
+    }
 
     auto end = chrono::high_resolution_clock::now();
 
@@ -26,7 +167,7 @@ int main(int argc, char* argv[]) {
 
     cout << "\nTotal time: " << durationMs << " ms\n";
 
-    return 0;
+    return finish(exitCode, timeReportJson, traceFile);
 }
 
 // #include "compiler.h"
@@ -817,6 +817,7 @@ private:
     }
 
     ASTPtr parseFunctionDeclaration() {
+        TRACE_SCOPE("parseFunctionDeclaration", peek(1).value);
         Token returnToken = currentToken;  // Capture return type position
         TokenType returnType = currentToken.type;
         advance();
@@ -1086,6 +1087,7 @@ public:
 };
 
 vector<unique_ptr<ASTNode>> parseFromFile(const vector<Token>& tokens) {
+    PhaseTimer timer("parse");
     try {
         Parser parser(tokens);
         auto ast = parser.parseProgram();
@@ -1102,10 +1104,10 @@ vector<unique_ptr<ASTNode>> parseFromFile(const vector<Token>& tokens) {
         cerr << "[Parser Error] " << e.message
              << " (line " << e.token.line
              << ", col " << e.token.column << ")\n";
-        exit(EXIT_FAILURE);
+        throw CompilationError("parsing failed");
     } 
     catch (const exception& e) {
         cerr << "[Parser Exception] " << e.what() << "\n";
-        exit(EXIT_FAILURE);
+        throw CompilationError("parsing failed");
     }
 }
\ No newline at end of file
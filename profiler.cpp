@@ -0,0 +1,237 @@
+#include "compiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <mutex>
+#include <new>
+#include <thread>
+
+#ifdef _WIN32
+#define PSAPI_VERSION 2
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// === Allocation Counting ===
+// Every allocation in the process goes through here. The counters are per thread so a
+// phase running on a batch worker only sees its own allocations.
+static thread_local size_t threadAllocations = 0;
+static thread_local size_t threadAllocatedBytes = 0;
+
+void* operator new(size_t size) {
+    threadAllocations++;
+    threadAllocatedBytes += size;
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+// Peak resident set size of the whole process, in KB
+static size_t peakRssKb() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize / 1024;
+    }
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;  // bytes on macOS
+#else
+    return usage.ru_maxrss;         // KB on Linux
+#endif
+#endif
+}
+
+// === Phase Report ===
+
+struct PhaseStats {
+    string name;
+    size_t calls = 0;
+    double wallMs = 0;
+    size_t allocations = 0;
+    size_t allocatedBytes = 0;
+    size_t peakRssKb = 0;
+};
+
+// Phases keep the order they first ran in; batch mode folds every file into one row per phase
+static vector<PhaseStats> phaseReport;
+static mutex phaseReportLock;
+
+static void recordPhase(const char* name, double wallMs, size_t allocations, size_t bytes) {
+    size_t rss = peakRssKb();
+    lock_guard<mutex> guard(phaseReportLock);
+    auto it = find_if(phaseReport.begin(), phaseReport.end(),
+                      [&](const PhaseStats& s) { return s.name == name; });
+    if (it == phaseReport.end()) {
+        phaseReport.push_back(PhaseStats{name});
+        it = phaseReport.end() - 1;
+    }
+    it->calls++;
+    it->wallMs += wallMs;
+    it->allocations += allocations;
+    it->allocatedBytes += bytes;
+    it->peakRssKb = max(it->peakRssKb, rss);
+}
+
+PhaseTimer::PhaseTimer(const char* phaseName)
+    : name(phaseName), active(compilerOptions.timeReport), startNs(0), startAllocations(0), startBytes(0),
+      span(phaseName) {
+    if (!active) return;
+    startAllocations = threadAllocations;
+    startBytes = threadAllocatedBytes;
+    startNs = chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+PhaseTimer::~PhaseTimer() {
+    if (!active) return;
+    long long endNs = chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+    recordPhase(name, (endNs - startNs) / 1e6,
+                threadAllocations - startAllocations, threadAllocatedBytes - startBytes);
+}
+
+void printTimeReport(ostream& out) {
+    lock_guard<mutex> guard(phaseReportLock);
+    double totalMs = 0;
+    size_t totalAllocs = 0, totalBytes = 0, peak = 0;
+
+    out << "\n=== Time Report ===\n";
+    out << left << setw(14) << "Phase" << right
+        << setw(8) << "Calls" << setw(12) << "Wall (ms)" << setw(12) << "Allocs"
+        << setw(14) << "Alloc KB" << setw(14) << "Peak RSS KB" << "\n";
+    for (const auto& s : phaseReport) {
+        out << left << setw(14) << s.name << right
+            << setw(8) << s.calls
+            << setw(12) << fixed << setprecision(3) << s.wallMs
+            << setw(12) << s.allocations
+            << setw(14) << setprecision(1) << s.allocatedBytes / 1024.0
+            << setw(14) << s.peakRssKb << "\n";
+        totalMs += s.wallMs;
+        totalAllocs += s.allocations;
+        totalBytes += s.allocatedBytes;
+        peak = max(peak, s.peakRssKb);
+    }
+    out << left << setw(14) << "total" << right << setw(8) << ""
+        << setw(12) << setprecision(3) << totalMs
+        << setw(12) << totalAllocs
+        << setw(14) << setprecision(1) << totalBytes / 1024.0
+        << setw(14) << peak << "\n";
+    out << defaultfloat;
+}
+
+bool writeTimeReportJSON(const string& filename) {
+    ofstream out(filename);
+    if (!out.is_open()) {
+        cerr << "Failed to open time report file: " << filename << endl;
+        return false;
+    }
+
+    lock_guard<mutex> guard(phaseReportLock);
+    double totalMs = 0;
+    size_t peak = 0;
+    out << "{\n  \"phases\": [\n";
+    for (size_t i = 0; i < phaseReport.size(); i++) {
+        const PhaseStats& s = phaseReport[i];
+        out << "    {\"name\": \"" << s.name << "\", \"calls\": " << s.calls
+            << ", \"wall_ms\": " << fixed << setprecision(3) << s.wallMs
+            << ", \"allocations\": " << s.allocations
+            << ", \"allocated_bytes\": " << s.allocatedBytes
+            << ", \"peak_rss_kb\": " << s.peakRssKb << "}"
+            << (i + 1 < phaseReport.size() ? "," : "") << "\n";
+        totalMs += s.wallMs;
+        peak = max(peak, s.peakRssKb);
+    }
+    out << "  ],\n  \"total_wall_ms\": " << totalMs << ",\n  \"peak_rss_kb\": " << peak << "\n}\n";
+    return true;
+}
+
+// === Trace Events ===
+
+struct TraceEvent {
+    const char* name;
+    string detail;
+    long long startUs;
+    long long durationUs;
+    int tid;
+};
+
+static vector<TraceEvent> traceEvents;
+static mutex traceEventsLock;
+
+static long long traceClockUs() {
+    static const auto origin = chrono::steady_clock::now();
+    return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - origin).count();
+}
+
+// Small stable ids read better in the trace viewer than hashed std::thread::ids
+static int traceThreadId() {
+    static atomic<int> nextId{1};
+    static thread_local int id = nextId++;
+    return id;
+}
+
+void TraceSpan::begin(const string& spanDetail) {
+    detail = spanDetail;
+    startUs = traceClockUs();
+}
+
+void TraceSpan::end() {
+    long long endUs = traceClockUs();
+    lock_guard<mutex> guard(traceEventsLock);
+    traceEvents.push_back({name, move(detail), startUs, endUs - startUs, traceThreadId()});
+}
+
+static string jsonEscape(const string& s) {
+    string out;
+    for (unsigned char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (c < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+bool writeTraceJSON(const string& filename) {
+    ofstream out(filename);
+    if (!out.is_open()) {
+        cerr << "Failed to open trace file: " << filename << endl;
+        return false;
+    }
+
+    lock_guard<mutex> guard(traceEventsLock);
+    out << "{\"traceEvents\": [\n";
+    for (size_t i = 0; i < traceEvents.size(); i++) {
+        const TraceEvent& e = traceEvents[i];
+        out << "  {\"name\": \"" << e.name;
+        if (!e.detail.empty()) out << " " << jsonEscape(e.detail);
+        out << "\", \"cat\": \"compiler\", \"ph\": \"X\", \"ts\": " << e.startUs
+            << ", \"dur\": " << e.durationUs << ", \"pid\": 1, \"tid\": " << e.tid;
+        if (!e.detail.empty()) out << ", \"args\": {\"function\": \"" << jsonEscape(e.detail) << "\"}";
+        out << "}" << (i + 1 < traceEvents.size() ? "," : "") << "\n";
+    }
+    out << "], \"displayTimeUnit\": \"ms\"}\n";
+    return true;
+}
@@ -0,0 +1,64 @@
+#include "backend.h"
+
+#include <cstdio>
+#include <cstring>
+
+// === Buffered Output Runtime ===
+// Generated code prints through these entry points instead of calling printf for every value.
+// Output collects in one userspace buffer that reaches stdio only when it fills up or when the
+// program's main returns, so a print costs a memcpy and no stdio locking or format parsing.
+// The buffer is process-wide; JIT-compiled programs run one at a time on the calling thread.
+// Native executables carry an IR copy of this runtime (llvm.cpp); keep the output identical.
+
+static char outputBuffer[1 << 16];
+static size_t outputUsed = 0;
+
+extern "C" void __rt_flush() {
+    if (outputUsed > 0) {
+        fwrite(outputBuffer, 1, outputUsed, stdout);
+        outputUsed = 0;
+    }
+    fflush(stdout);
+}
+
+static void writeBytes(const char* data, size_t length) {
+    if (outputUsed + length > sizeof(outputBuffer)) {
+        __rt_flush();
+        if (length > sizeof(outputBuffer)) {
+            fwrite(data, 1, length, stdout);
+            return;
+        }
+    }
+    memcpy(outputBuffer + outputUsed, data, length);
+    outputUsed += length;
+}
+
+extern "C" void __rt_print_int(int32_t value) {
+    // Digits are produced back to front; the magnitude is unsigned so INT32_MIN works
+    char digits[12];
+    char* end = digits + sizeof(digits);
+    char* p = end;
+    uint32_t magnitude = value < 0 ? 0u - static_cast<uint32_t>(value) : static_cast<uint32_t>(value);
+    do {
+        *--p = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (value < 0) *--p = '-';
+    writeBytes(p, end - p);
+}
+
+// Same text as printf("%f")
+extern "C" void __rt_print_float(double value) {
+    char text[512];
+    int length = snprintf(text, sizeof(text), "%f", value);
+    if (length > 0) writeBytes(text, min(static_cast<size_t>(length), sizeof(text) - 1));
+}
+
+extern "C" void __rt_print_str(const char* text) {
+    if (text) writeBytes(text, strlen(text));
+}
+
+extern "C" void __rt_print_char(int32_t value) {
+    if (outputUsed == sizeof(outputBuffer)) __rt_flush();
+    outputBuffer[outputUsed++] = static_cast<char>(value);
+}
@@ -129,6 +129,7 @@ private:
     
     // Analyze a function definition
     void analyzeFunctionDecl(const FunctionDecl& func) {
+        TRACE_SCOPE("analyzeFunctionDecl", func.name);
         int line = func.line;
         int col = func.column;
         
@@ -769,6 +770,7 @@ public:
 };
 
 void performScopeAnalysis(const vector<ASTPtr>& ast, const vector<Token>& tokens) {
+    PhaseTimer timer("scope");
     try {
         ScopeAnalyzer analyzer;
         vector<ScopeError> errors = analyzer.analyze(ast, tokens);
@@ -779,15 +781,20 @@ void performScopeAnalysis(const vector<ASTPtr>& ast, const vector<Token>& tokens
                 cerr << "[Scope Error] " << error.message << ")\n";
             }
             cerr << "Scope analysis failed with " << errors.size() << " error(s)\n";
-            exit(EXIT_FAILURE);
+            throw CompilationError("scope analysis failed with " + to_string(errors.size()) + " error(s)");
         }
 
-        cout << "\n=== Scope Analysis Successful ===\n";
-        cout << "No scope errors found.\n";
+        if (!compilerOptions.quiet) {
+            cout << "\n=== Scope Analysis Successful ===\n";
+            cout << "No scope errors found.\n";
+        }
 
     }
+    catch (const CompilationError&) {
+        throw;
+    }
     catch (const exception& e) {
         cerr << "[Scope Analysis Exception] " << e.what() << "\n";
-        exit(EXIT_FAILURE);
+        throw CompilationError("scope analysis failed");
     }
 }
\ No newline at end of file
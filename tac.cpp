@@ -2,13 +2,25 @@
 #include <fstream>
 #include <sstream>
 #include <unordered_map>
+#include <unordered_set>
 #include <stack>
 
 using namespace std;
 
 class TACGenerator {
 private:
-    ofstream outputFile;
+    // A function's lines in `lines` and the functions it calls
+    struct FunctionText {
+        string name;
+        size_t begin, end;
+        unordered_set<string> callees;
+    };
+    
+    vector<string> lines;
+    vector<FunctionText> functions;
+    unordered_set<string> rootCallees;  // called outside any function
+    unordered_set<string> jumpTargets;
+    bool reachable = true;  // whether control can reach the next emitted line
     int tempCounter;
     int labelCounter;
     int indentLevel;  // Track indentation level
@@ -29,18 +41,7 @@ private:
         }
     }
 public:
-    TACGenerator(const string& filename) 
-        : outputFile(filename), tempCounter(0), labelCounter(0), indentLevel(0) {
-        if (!outputFile.is_open()) {
-            throw runtime_error("Cannot open output file for TAC");
-        }
-    }
-    
-    ~TACGenerator() {
-        if (outputFile.is_open()) {
-            outputFile.close();
-        }
-    }
+    TACGenerator() : tempCounter(0), labelCounter(0), indentLevel(0) {}
     
     void generate(const vector<ASTPtr>& ast) {
         for (const auto& node : ast) {
@@ -49,6 +50,45 @@ public:
             }
         }
     }
+    
+    // The generated TAC without labels nothing jumps to and without functions that main
+    // never calls, directly or indirectly. Without a main every function is kept.
+    string text() const {
+        unordered_map<string, const FunctionText*> byName;
+        for (const auto& function : functions) byName[function.name] = &function;
+        
+        unordered_set<string> live;
+        if (byName.count("main")) {
+            vector<string> work(rootCallees.begin(), rootCallees.end());
+            work.push_back("main");
+            while (!work.empty()) {
+                string name = std::move(work.back());
+                work.pop_back();
+                auto it = byName.find(name);
+                if (it == byName.end() || !live.insert(name).second) continue;
+                work.insert(work.end(), it->second->callees.begin(), it->second->callees.end());
+            }
+        }
+        
+        string result;
+        size_t next = 0;
+        auto append = [&](size_t from, size_t to) {
+            for (size_t i = from; i < to; i++) {
+                const string& line = lines[i];
+                if (!line.empty() && line.back() == ':' && !jumpTargets.count(line.substr(0, line.size() - 1))) continue;
+                result += line;
+                result += '\n';
+            }
+        };
+        for (const auto& function : functions) {
+            if (!live.empty() && !live.count(function.name)) {
+                append(next, function.begin);
+                next = function.end;
+            }
+        }
+        append(next, lines.size());
+        return result;
+    }
 
 private:
     string newTemp() {
@@ -59,14 +99,57 @@ private:
         return "L" + to_string(labelCounter++);
     }
     
+    // Nothing is emitted while the current position is unreachable (after a return or a
+    // jump, until a label some emitted jump targets)
     void emit(const string& code) {
+        if (!reachable) return;
         // Add indentation before emitting code
-        outputFile << string(indentLevel * 2, ' ') << code << endl;
+        lines.push_back(string(indentLevel * 2, ' ') + code);
     }
     
     void emitLabel(const string& label) {
+        if (!reachable && !jumpTargets.count(label)) return;
         // Labels are not indented (or minimally indented)
-        outputFile << label << ":" << endl;
+        lines.push_back(label + ":");
+        reachable = true;
+    }
+    
+    void emitJump(const string& code, const string& target) {
+        if (!reachable) return;
+        emit(code);
+        jumpTargets.insert(target);
+    }
+    
+    void emitGoto(const string& label) {
+        emitJump("goto " + label, label);
+        reachable = false;
+    }
+    
+    // Statements after one that leaves the block (return, break) are never lowered: no
+    // label inside them can be the target of a jump from outside
+    void processStatements(const vector<ASTPtr>& body) {
+        for (const auto& stmt : body) {
+            if (!reachable) break;
+            if (stmt) processNode(stmt->node);
+        }
+    }
+    
+    // Function text starts before its header line; a call outside of any function is a root
+    void beginFunction(const string& name) {
+        reachable = true;
+        functions.push_back({name, lines.size(), 0, {}});
+    }
+    
+    void endFunction(const string& name) {
+        reachable = true;
+        emit("function " + name + " end");
+        functions.back().end = lines.size();
+    }
+    
+    void noteCall(const string& callee) {
+        if (!reachable) return;
+        if (currentFunction.empty()) rootCallees.insert(callee);
+        else functions.back().callees.insert(callee);
     }
     
     void increaseIndent() { indentLevel++; }
@@ -169,6 +252,15 @@ private:
     // }
     
     string processBinaryExpr(const BinaryExpr& expr) {
+        // The parser represents "(expr)" as BinaryExpr(T_LPAREN, expr, nullptr)
+        if (expr.op == T_LPAREN || !expr.right) {
+            return processNode(expr.left->node);
+        }
+        
+        if (expr.op == T_AND || expr.op == T_OR) {
+            return processLogicalExpr(expr);
+        }
+        
         string left = processNode(expr.left->node);
         string right = processNode(expr.right->node);
         
@@ -185,6 +277,139 @@ private:
         return result;
     }
     
+    // Whether an operand can be evaluated even when && or || would skip it: no calls, no
+    // assignments, nothing that can trap (division, modulo) and at most `budget` operators
+    static bool canSpeculate(const ASTNode& node, int& budget) {
+        return visit([&budget](const auto& n) -> bool {
+            using T = decay_t<decltype(n)>;
+            if constexpr (is_same_v<T, IntLiteral> || is_same_v<T, FloatLiteral> || is_same_v<T, CharLiteral> ||
+                          is_same_v<T, BoolLiteral> || is_same_v<T, Identifier>) {
+                return true;
+            }
+            else if constexpr (is_same_v<T, BinaryExpr>) {
+                if (n.op == T_LPAREN || !n.right) return n.left && canSpeculate(*n.left, budget);
+                if (n.op == T_ASSIGNOP || n.op == T_DIVIDE || n.op == T_MODULO || --budget < 0) return false;
+                return canSpeculate(*n.left, budget) && canSpeculate(*n.right, budget);
+            }
+            else if constexpr (is_same_v<T, UnaryExpr>) {
+                if (n.op == T_INCREMENT || n.op == T_DECREMENT || --budget < 0) return false;
+                return canSpeculate(*n.operand, budget);
+            }
+            else return false;
+        }, node.node);
+    }
+    
+    static bool canSpeculate(const ASTNode& node) {
+        int budget = 4;
+        return canSpeculate(node, budget);
+    }
+    
+    // && and || as a value. A cheap, side-effect free right operand is evaluated anyway and
+    // combined without a branch; otherwise it only runs when the left operand does not decide
+    // the result, and the result lives in a local whose `$` keeps it apart from source names.
+    string processLogicalExpr(const BinaryExpr& expr) {
+        bool isAnd = expr.op == T_AND;
+        string left = processNode(expr.left->node);
+        
+        if (canSpeculate(*expr.right)) {
+            string right = processNode(expr.right->node);
+            string result = newTemp();
+            emit(result + " = " + left + (isAnd ? " && " : " || ") + right);
+            return result;
+        }
+        
+        string result = "$" + newTemp();
+        string endLabel = newLabel();
+        emit("bool " + result + " = " + left);
+        emitJump("if " + result + (isAnd ? " == 0" : " != 0") + " goto " + endLabel, endLabel);
+        increaseIndent();
+        string right = processNode(expr.right->node);
+        emit(result + " = " + right);
+        decreaseIndent();
+        emitLabel(endLabel);
+        return result;
+    }
+    
+    // === Conditions ===
+    // A branch condition becomes jumps rather than a value: && and || test one operand at a
+    // time, ! swaps the targets, and a comparison is fused into its jump.
+    
+    static const ASTNode& unparenthesize(const ASTNode& node) {
+        if (auto bin = get_if<BinaryExpr>(&node.node)) {
+            if ((bin->op == T_LPAREN || !bin->right) && bin->left) return unparenthesize(*bin->left);
+        }
+        return node;
+    }
+    
+    void emitJumpIfFalse(const ASTNode& condition, const string& falseLabel) {
+        const ASTNode& cond = unparenthesize(condition);
+        if (auto bin = get_if<BinaryExpr>(&cond.node)) {
+            if ((bin->op == T_AND || bin->op == T_OR) && !canSpeculate(*bin->right)) {
+                if (bin->op == T_AND) {
+                    emitJumpIfFalse(*bin->left, falseLabel);
+                    emitJumpIfFalse(*bin->right, falseLabel);
+                } else {
+                    string trueLabel = newLabel();
+                    emitJumpIfTrue(*bin->left, trueLabel);
+                    emitJumpIfFalse(*bin->right, falseLabel);
+                    emitLabel(trueLabel);
+                }
+                return;
+            }
+        }
+        if (auto unary = get_if<UnaryExpr>(&cond.node)) {
+            if (unary->op == T_NOT) {
+                emitJumpIfTrue(*unary->operand, falseLabel);
+                return;
+            }
+        }
+        emitConditionalJump(cond, false, falseLabel);
+    }
+    
+    void emitJumpIfTrue(const ASTNode& condition, const string& trueLabel) {
+        const ASTNode& cond = unparenthesize(condition);
+        if (auto bin = get_if<BinaryExpr>(&cond.node)) {
+            if ((bin->op == T_AND || bin->op == T_OR) && !canSpeculate(*bin->right)) {
+                if (bin->op == T_OR) {
+                    emitJumpIfTrue(*bin->left, trueLabel);
+                    emitJumpIfTrue(*bin->right, trueLabel);
+                } else {
+                    string falseLabel = newLabel();
+                    emitJumpIfFalse(*bin->left, falseLabel);
+                    emitJumpIfTrue(*bin->right, trueLabel);
+                    emitLabel(falseLabel);
+                }
+                return;
+            }
+        }
+        if (auto unary = get_if<UnaryExpr>(&cond.node)) {
+            if (unary->op == T_NOT) {
+                emitJumpIfFalse(*unary->operand, trueLabel);
+                return;
+            }
+        }
+        emitConditionalJump(cond, true, trueLabel);
+    }
+    
+    // A comparison goes into the jump itself (if a < b goto L); any other condition is
+    // evaluated and tested against zero
+    void emitConditionalJump(const ASTNode& cond, bool whenTrue, const string& label) {
+        if (auto bin = get_if<BinaryExpr>(&cond.node)) {
+            switch (bin->op) {
+                case T_EQUALOP: case T_NE: case T_LT: case T_GT: case T_LE: case T_GE: {
+                    string left = processNode(bin->left->node);
+                    string right = processNode(bin->right->node);
+                    emitJump(string(whenTrue ? "if " : "ifFalse ") + left + " " + getOperatorString(bin->op) + " " + right + " goto " + label, label);
+                    return;
+                }
+                default:
+                    break;
+            }
+        }
+        string value = processNode(cond.node);
+        emitJump("if " + value + (whenTrue ? " != 0" : " == 0") + " goto " + label, label);
+    }
+    
     string getOperatorString(TokenType op) {
         switch (op) {
             case T_PLUS: return "+";
@@ -280,6 +505,7 @@ private:
             return "";
         }
         
+        noteCall(callee);
         string result = newTemp();
         emit(result + " = call " + callee + "(" + argsStr + ")");
         return result;
@@ -297,9 +523,7 @@ private:
     }
 
     void processBlockStmt(const BlockStmt& stmt) {
-        for (const auto& s : stmt.body) {
-            if (s) processNode(s->node);
-        }
+        processStatements(stmt.body);
     }
     
     void processFunctionProto(const FunctionProto& proto) {
@@ -307,6 +531,7 @@ private:
     }
     
     void processFunctionDecl(const FunctionDecl& func) {
+        TRACE_SCOPE("processFunctionDecl", func.name);
         string oldFunction = currentFunction;
         currentFunction = func.name;
         
@@ -314,6 +539,7 @@ private:
         // Include return type in function declaration
         string returnType = getTypeString(func.returnType);
         
+        beginFunction(func.name);
         emit("\n" + returnType + " function " + func.name + " begin");
         //emit("\nfunction " + func.name + " begin");
         increaseIndent();
@@ -326,9 +552,7 @@ private:
         }
         
         // Function body
-        for (const auto& stmt : func.body) {
-            if (stmt) processNode(stmt->node);
-        }
+        processStatements(func.body);
         
         // Implicit return for non-void functions
         /*if (func.returnType != T_VOID) {
@@ -336,47 +560,41 @@ private:
         }*/
         
         decreaseIndent();
-        emit("function " + func.name + " end");
+        endFunction(func.name);
         currentFunction = oldFunction;
     }
     
     void processMainDecl(const MainDecl& main) {
         currentFunction = "main";
+        beginFunction("main");
         emit("\nfunction main begin");
         increaseIndent();
         
-        for (const auto& stmt : main.body) {
-            if (stmt) processNode(stmt->node);
-        }
+        processStatements(main.body);
         
         // emit("return 0");
 
         decreaseIndent();
-        emit("function main end");
+        endFunction("main");
         currentFunction = "";
     }
     
     void processIfStmt(const IfStmt& stmt) {
-        string cond = processNode(stmt.condition->node);
         string elseLabel = newLabel();
         string endLabel = newLabel();
         
-        emit("if " + cond + " == 0 goto " + elseLabel);
+        emitJumpIfFalse(*stmt.condition, elseLabel);
         
         increaseIndent();
-        for (const auto& s : stmt.ifBody) {
-            if (s) processNode(s->node);
-        }
+        processStatements(stmt.ifBody);
         decreaseIndent();
         
         if (!stmt.elseBody.empty()) {
-            emit("goto " + endLabel);
+            emitGoto(endLabel);
             emitLabel(elseLabel);
             
             increaseIndent();
-            for (const auto& s : stmt.elseBody) {
-                if (s) processNode(s->node);
-            }
+            processStatements(stmt.elseBody);
             decreaseIndent();
             
             emitLabel(endLabel);
@@ -392,16 +610,13 @@ private:
         breakLabels.push(endLabel);
         
         emitLabel(startLabel);
-        string cond = processNode(stmt.condition->node);
-        emit("if " + cond + " == 0 goto " + endLabel);
+        emitJumpIfFalse(*stmt.condition, endLabel);
         
         increaseIndent();
-        for (const auto& s : stmt.body) {
-            if (s) processNode(s->node);
-        }
+        processStatements(stmt.body);
         decreaseIndent();
         
-        emit("goto " + startLabel);
+        emitGoto(startLabel);
         emitLabel(endLabel);
         
         breakLabels.pop();
@@ -418,8 +633,7 @@ private:
         processNode(stmt.body->node);
         decreaseIndent();
         
-        string cond = processNode(stmt.condition->node);
-        emit("if " + cond + " != 0 goto " + startLabel);
+        emitJumpIfTrue(*stmt.condition, startLabel);
         
         emitLabel(endLabel);
         breakLabels.pop();
@@ -440,8 +654,7 @@ private:
         
         // Condition
         if (stmt.condition) {
-            string cond = processNode(stmt.condition->node);
-            emit("if " + cond + " == 0 goto " + endLabel);
+            emitJumpIfFalse(*stmt.condition, endLabel);
         }
         
         // Loop body
@@ -454,12 +667,33 @@ private:
             processNode(stmt.update->node);
         }
         
-        emit("goto " + startLabel);
+        emitGoto(startLabel);
         emitLabel(endLabel);
         
         breakLabels.pop();
     }
     
+    // Value of a case label that is a literal (an int, possibly negated, or a char), as the
+    // switch compares it: chars by their unsigned code
+    static bool caseConstant(const ASTNode& node, int32_t& value) {
+        if (auto lit = get_if<IntLiteral>(&node.node)) {
+            value = lit->value;
+            return true;
+        }
+        if (auto lit = get_if<CharLiteral>(&node.node)) {
+            value = static_cast<unsigned char>(lit->value);
+            return true;
+        }
+        if (auto unary = get_if<UnaryExpr>(&node.node)) {
+            if (unary->op != T_MINUS || !unary->operand) return false;
+            if (auto lit = get_if<IntLiteral>(&unary->operand->node)) {
+                value = static_cast<int32_t>(0u - static_cast<uint32_t>(lit->value));
+                return true;
+            }
+        }
+        return false;
+    }
+    
     void processSwitchStmt(const SwitchStmt& stmt) {
         string expr = processNode(stmt.expression->node);
         string endLabel = newLabel();
@@ -470,28 +704,48 @@ private:
         vector<pair<string, const CaseBlock*>> caseLabelPairs;
         string defaultLabel = !stmt.defaultBody.empty() ? newLabel() : endLabel;
         
-        // Generate all case tests
+        vector<int32_t> caseValues;
+        bool allConstant = true;
         for (const auto& caseBlock : stmt.cases) {
             if (auto caseNode = get_if<CaseBlock>(&caseBlock->node)) {
-                string caseValue = processNode(caseNode->value->node);
-                string caseLabel = newLabel();
-                caseLabelPairs.push_back({caseLabel, caseNode});
-                
-                emit("if " + expr + " == " + caseValue + " goto " + caseLabel);
+                int32_t value;
+                if (caseNode->value && caseConstant(*caseNode->value, value)) {
+                    caseValues.push_back(value);
+                } else {
+                    allConstant = false;
+                }
+                caseLabelPairs.push_back({newLabel(), caseNode});
             }
         }
         
-        // Jump to default or end if no cases match
-        emit("goto " + defaultLabel);
+        if (allConstant) {
+            // One multiway branch: switch expr [value: label, ...] default label
+            // The first case with a given value wins, as in the comparison chain
+            string line = "switch " + expr + " [";
+            unordered_set<int32_t> seen;
+            bool first = true;
+            for (size_t i = 0; i < caseValues.size(); i++) {
+                if (!seen.insert(caseValues[i]).second) continue;
+                if (!first) line += ", ";
+                line += to_string(caseValues[i]) + ": " + caseLabelPairs[i].first;
+                if (reachable) jumpTargets.insert(caseLabelPairs[i].first);
+                first = false;
+            }
+            emitJump(line + "] default " + defaultLabel, defaultLabel);
+            reachable = false;
+        } else {
+            // Case values are evaluated and compared in order
+            for (const auto& [caseLabel, caseNode] : caseLabelPairs) {
+                string caseValue = processNode(caseNode->value->node);
+                emitJump("if " + expr + " == " + caseValue + " goto " + caseLabel, caseLabel);
+            }
+            emitGoto(defaultLabel);
+        }
         
         for (const auto& [caseLabel, caseNode] : caseLabelPairs) {
             emitLabel(caseLabel);
             increaseIndent();
-            
-            for (const auto& stmt : caseNode->body) {
-                if (stmt) processNode(stmt->node);
-            }
-            
+            processStatements(caseNode->body);
             decreaseIndent();
         }
         
@@ -499,9 +753,7 @@ private:
         if (!stmt.defaultBody.empty()) {
             emitLabel(defaultLabel);
             increaseIndent();
-            for (const auto& stmt : stmt.defaultBody) {
-                if (stmt) processNode(stmt->node);
-            }
+            processStatements(stmt.defaultBody);
             decreaseIndent();
         }
         
@@ -516,18 +768,22 @@ private:
         } else {
             emit("return");
         }
+        reachable = false;
     }
     
+    // One call per statement, so the backend can lower it to a single printf
     void processPrintStmt(const PrintStmt& stmt) {
-        for (const auto& arg : stmt.args) {
-            string argVal = processNode(arg->node);
-            emit("call print(" + argVal + ")");
+        string argsStr;
+        for (size_t i = 0; i < stmt.args.size(); ++i) {
+            if (i > 0) argsStr += ", ";
+            argsStr += processNode(stmt.args[i]->node);
         }
+        emit("call print(" + argsStr + ")");
     }
     
     void processBreakStmt(const BreakStmt& stmt) {
         if (!breakLabels.empty()) {
-            emit("goto " + breakLabels.top());
+            emitGoto(breakLabels.top());
         }
     }
     
@@ -539,12 +795,31 @@ private:
 };
 
 void generateTAC(const vector<ASTPtr>& ast, const string& outputFilename) {
-    try {
-        TACGenerator generator(outputFilename);
-        generator.generate(ast);
+    string tac;
+    {
+        PhaseTimer timer("tac");
+        try {
+            TACGenerator generator;
+            generator.generate(ast);
+            tac = generator.text();
+        } catch (const exception& e) {
+            cerr << "TAC Generation Error: " << e.what() << endl;
+            throw CompilationError("TAC generation failed");
+        }
+    }
+    
+    // Optimized before it is written, so the file always shows what the backend runs
+    if (compilerOptions.optimizeTAC) {
+        PhaseTimer timer("tac-opt");
+        tac = optimizeTAC(tac);
+    }
+    
+    ofstream outputFile(outputFilename);
+    if (!outputFile.is_open() || !(outputFile << tac)) {
+        cerr << "TAC Generation Error: Cannot open output file for TAC" << endl;
+        throw CompilationError("TAC generation failed");
+    }
+    if (!compilerOptions.quiet) {
         cout << "TAC generation successful. Output written to: " << outputFilename << endl;
-    } catch (const exception& e) {
-        cerr << "TAC Generation Error: " << e.what() << endl;
-        exit(EXIT_FAILURE);
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,438 @@
+#include "compiler.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+// === TAC Control Flow Graph ===
+// Basic blocks of one TAC function with successor and predecessor lists and the dominator
+// tree. The TAC optimizer builds it over its parsed statements and TACExecutor over the lines
+// it reads, so both see the same blocks: TACExecutor creates one LLVM block per reachable TAC
+// block and never lowers the others.
+//
+// A jump to a label the function does not define is ignored by TACExecutor, so here it falls
+// through like any other statement.
+//
+// The TAC optimizer's global passes also build the function's SSA form on top of the graph
+// (buildTACSSA below).
+
+static string_view trimView(string_view s) {
+    size_t start = s.find_first_not_of(" \t");
+    if (start == string_view::npos) return {};
+    return s.substr(start, s.find_last_not_of(" \t") - start + 1);
+}
+
+TACControl classifyTACStatement(string_view stmt) {
+    TACControl control;
+    if (stmt.empty() || stmt.substr(0, 2) == "//") return control;
+
+    if (stmt.back() == ':') {
+        control.kind = TACControl::LABEL;
+        control.label = stmt.substr(0, stmt.size() - 1);
+        return control;
+    }
+    // Same order as TACExecutor::processStatement: calls and assignments never jump
+    if (stmt.substr(0, 5) == "call ") return control;
+
+    if (stmt.substr(0, 7) == "switch ") {
+        size_t open = stmt.find(" [");
+        size_t close = stmt.rfind("] default ");
+        if (open == string_view::npos || close == string_view::npos || close < open) return control;
+        control.kind = TACControl::SWITCH;
+        control.label = trimView(stmt.substr(close + 10));
+        string_view list = stmt.substr(open + 2, close - open - 2);
+        while (!list.empty()) {
+            size_t comma = list.find(", ");
+            string_view entry = list.substr(0, comma);
+            size_t colon = entry.find(": ");
+            if (colon != string_view::npos) control.cases.push_back(trimView(entry.substr(colon + 2)));
+            list = comma == string_view::npos ? string_view() : list.substr(comma + 2);
+        }
+        return control;
+    }
+
+    if (stmt.find(" = ") != string_view::npos) return control;
+
+    size_t gotoPos = stmt.find(" goto ");
+    if ((stmt.substr(0, 3) == "if " || stmt.substr(0, 8) == "ifFalse ") && gotoPos != string_view::npos) {
+        control.kind = TACControl::BRANCH;
+        control.label = trimView(stmt.substr(gotoPos + 6));
+    } else if (stmt.substr(0, 5) == "goto ") {
+        control.kind = TACControl::GOTO;
+        control.label = trimView(stmt.substr(5));
+    } else if (stmt.substr(0, 6) == "return") {
+        control.kind = TACControl::RETURN;
+    }
+    return control;
+}
+
+bool TACControlFlowGraph::dominates(size_t a, size_t b) const {
+    if (!blocks[a].reachable || !blocks[b].reachable) return false;
+    return blocks[a].domFirst <= blocks[b].domFirst && blocks[b].domFirst <= blocks[a].domLast;
+}
+
+vector<size_t> TACControlFlowGraph::naturalLoop(size_t header, size_t tail) const {
+    vector<size_t> loop = {header};
+    unordered_set<size_t> inLoop = {header};
+    vector<size_t> worklist;
+    if (inLoop.insert(tail).second) {
+        loop.push_back(tail);
+        worklist.push_back(tail);
+    }
+    while (!worklist.empty()) {
+        size_t block = worklist.back();
+        worklist.pop_back();
+        for (size_t pred : blocks[block].preds) {
+            if (!inLoop.insert(pred).second) continue;
+            loop.push_back(pred);
+            worklist.push_back(pred);
+        }
+    }
+    return loop;
+}
+
+vector<vector<size_t>> TACControlFlowGraph::dominanceFrontiers() const {
+    vector<vector<size_t>> frontiers(blocks.size());
+    for (size_t b : order) {
+        const TACBlock& block = blocks[b];
+        // The entry is also entered from outside, so any edge back to it makes it a join
+        if (block.preds.size() < 2 && (b != 0 || block.preds.empty())) continue;
+        for (size_t pred : block.preds) {
+            for (size_t runner = pred;; runner = blocks[runner].idom) {
+                if (b != 0 && runner == block.idom) break;
+                if (frontiers[runner].empty() || frontiers[runner].back() != b) frontiers[runner].push_back(b);
+                if (runner == 0) break;
+            }
+        }
+    }
+    return frontiers;
+}
+
+// Edges out of `block`: its last statement's targets, plus the next block unless it ends in an
+// unconditional jump or a return
+static void addSuccessors(TACControlFlowGraph& cfg, size_t block, const TACControl& last) {
+    auto target = [&](string_view label) -> size_t {
+        auto it = cfg.blockByLabel.find(label);
+        return it == cfg.blockByLabel.end() ? SIZE_MAX : it->second;
+    };
+    vector<size_t>& succs = cfg.blocks[block].succs;
+    bool fallsThrough = true;
+    if (last.kind == TACControl::GOTO || last.kind == TACControl::BRANCH) {
+        size_t to = target(last.label);
+        if (to != SIZE_MAX) {
+            succs.push_back(to);
+            fallsThrough = last.kind == TACControl::BRANCH;
+        }
+    } else if (last.kind == TACControl::SWITCH) {
+        size_t to = target(last.label);
+        if (to != SIZE_MAX) {
+            succs.push_back(to);
+            for (string_view label : last.cases) {
+                size_t caseTo = target(label);
+                if (caseTo != SIZE_MAX) succs.push_back(caseTo);
+            }
+            fallsThrough = false;
+        }
+    } else if (last.kind == TACControl::RETURN) {
+        fallsThrough = false;
+    }
+    if (fallsThrough && block + 1 < cfg.blocks.size()) succs.push_back(block + 1);
+
+    sort(succs.begin(), succs.end());
+    succs.erase(unique(succs.begin(), succs.end()), succs.end());
+}
+
+// Cooper, Harvey and Kennedy's iterative algorithm over the reverse postorder
+static void computeDominators(TACControlFlowGraph& cfg) {
+    vector<size_t> position(cfg.blocks.size(), SIZE_MAX);
+    for (size_t i = 0; i < cfg.order.size(); i++) position[cfg.order[i]] = i;
+
+    auto intersect = [&](size_t a, size_t b) {
+        while (a != b) {
+            while (position[a] > position[b]) a = cfg.blocks[a].idom;
+            while (position[b] > position[a]) b = cfg.blocks[b].idom;
+        }
+        return a;
+    };
+
+    cfg.blocks[0].idom = 0;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 1; i < cfg.order.size(); i++) {
+            TACBlock& block = cfg.blocks[cfg.order[i]];
+            size_t idom = SIZE_MAX;
+            for (size_t pred : block.preds) {
+                if (cfg.blocks[pred].idom == SIZE_MAX) continue;
+                idom = idom == SIZE_MAX ? pred : intersect(pred, idom);
+            }
+            if (idom != block.idom) {
+                block.idom = idom;
+                changed = true;
+            }
+        }
+    }
+
+    // Preorder intervals of the dominator tree, so dominates() need not walk idom chains
+    vector<vector<size_t>> children(cfg.blocks.size());
+    for (size_t i = 1; i < cfg.order.size(); i++) children[cfg.blocks[cfg.order[i]].idom].push_back(cfg.order[i]);
+    size_t counter = 0;
+    vector<pair<size_t, size_t>> stack = {{0, 0}};   // block, next child
+    cfg.blocks[0].domFirst = counter++;
+    while (!stack.empty()) {
+        auto& [block, next] = stack.back();
+        if (next < children[block].size()) {
+            size_t child = children[block][next++];
+            cfg.blocks[child].domFirst = counter++;
+            stack.push_back({child, 0});
+        } else {
+            cfg.blocks[block].domLast = counter - 1;
+            stack.pop_back();
+        }
+    }
+}
+
+TACControlFlowGraph buildTACControlFlowGraph(const vector<TACControl>& statements) {
+    TACControlFlowGraph cfg;
+    cfg.blockOf.resize(statements.size());
+
+    // Blocks and the labels that start them
+    for (size_t i = 0; i < statements.size(); i++) {
+        const TACControl& control = statements[i];
+        TACControl::Kind previous = i > 0 ? statements[i - 1].kind : TACControl::NONE;
+        bool starts = i == 0 || control.kind == TACControl::LABEL ||
+                      (previous != TACControl::NONE && previous != TACControl::LABEL);
+        if (starts) {
+            if (!cfg.blocks.empty()) cfg.blocks.back().end = i;
+            cfg.blocks.emplace_back();
+            cfg.blocks.back().begin = i;
+        }
+        if (control.kind == TACControl::LABEL) cfg.blockByLabel.emplace(control.label, cfg.blocks.size() - 1);
+        cfg.blockOf[i] = cfg.blocks.size() - 1;
+    }
+    if (cfg.blocks.empty()) cfg.blocks.emplace_back();
+    cfg.blocks.back().end = statements.size();
+
+    for (size_t b = 0; b < cfg.blocks.size(); b++) {
+        const TACBlock& block = cfg.blocks[b];
+        addSuccessors(cfg, b, block.end > block.begin ? statements[block.end - 1] : TACControl());
+    }
+
+    // Depth-first from the entry: reachability, postorder, then predecessors among reachable blocks
+    vector<size_t> postorder;
+    vector<pair<size_t, size_t>> stack = {{0, 0}};
+    cfg.blocks[0].reachable = true;
+    while (!stack.empty()) {
+        auto& [block, next] = stack.back();
+        if (next < cfg.blocks[block].succs.size()) {
+            size_t succ = cfg.blocks[block].succs[next++];
+            if (!cfg.blocks[succ].reachable) {
+                cfg.blocks[succ].reachable = true;
+                stack.push_back({succ, 0});
+            }
+        } else {
+            postorder.push_back(block);
+            stack.pop_back();
+        }
+    }
+    cfg.order.assign(postorder.rbegin(), postorder.rend());
+    for (size_t b : cfg.order) {
+        for (size_t succ : cfg.blocks[b].succs) cfg.blocks[succ].preds.push_back(b);
+    }
+
+    computeDominators(cfg);
+    return cfg;
+}
+
+// === SSA Form ===
+// Cytron et al.: phis go on the iterated dominance frontiers of a name's assignments, pruned to
+// blocks where the name is live on entry, then a preorder walk of the dominator tree numbers
+// every def and resolves every use. Liveness is computed sparsely, name by name, rather than as
+// a dataflow problem over sets of all names, so a large function with many short-lived names
+// does not cost blocks x names.
+
+TACSSAForm buildTACSSA(const TACControlFlowGraph& cfg, const vector<TACDefUse>& statements) {
+    TACSSAForm ssa;
+    size_t blockCount = cfg.blocks.size();
+    ssa.phis.resize(blockCount);
+    ssa.defOf.assign(statements.size(), SIZE_MAX);
+    ssa.firstUse.resize(statements.size() + 1);
+    for (size_t i = 0; i < statements.size(); i++) ssa.firstUse[i + 1] = ssa.firstUse[i] + statements[i].uses.size();
+    ssa.uses.assign(ssa.firstUse.back(), SIZE_MAX);
+    ssa.values.reserve(statements.size() + blockCount);
+
+    // Names assigned in reachable blocks; until renaming, uses and defVariable hold name indices
+    unordered_map<string_view, size_t> variableOf;
+    variableOf.reserve(statements.size());
+    vector<size_t> defVariable(statements.size(), SIZE_MAX);
+    for (size_t b = 0; b < blockCount; b++) {
+        if (!cfg.blocks[b].reachable) continue;
+        for (size_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+            string_view def = statements[i].def;
+            if (def.empty()) continue;
+            auto [it, added] = variableOf.emplace(def, ssa.variables.size());
+            if (added) ssa.variables.emplace_back(def);
+            defVariable[i] = it->second;
+        }
+    }
+    for (size_t b = 0; b < blockCount; b++) {
+        if (!cfg.blocks[b].reachable) continue;
+        for (size_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+            for (size_t k = 0; k < statements[i].uses.size(); k++) {
+                auto it = variableOf.find(statements[i].uses[k]);
+                if (it != variableOf.end()) ssa.useOf(i, k) = it->second;
+            }
+        }
+    }
+    size_t variableCount = ssa.variables.size();
+
+    // Only names read before they are assigned in some block ("global" names) can be live on
+    // entry to a block, so only they take part in liveness and get phis
+    vector<size_t> globalOf(variableCount, SIZE_MAX);
+    vector<size_t> globals;
+    vector<size_t> lastAssigned(variableCount, SIZE_MAX);   // block that last assigned the name
+    for (size_t b : cfg.order) {
+        for (size_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+            for (size_t use = ssa.firstUse[i]; use < ssa.firstUse[i + 1]; use++) {
+                size_t v = ssa.uses[use];
+                if (v == SIZE_MAX || lastAssigned[v] == b || globalOf[v] != SIZE_MAX) continue;
+                globalOf[v] = globals.size();
+                globals.push_back(v);
+            }
+            if (defVariable[i] != SIZE_MAX) lastAssigned[defVariable[i]] = b;
+        }
+    }
+    size_t globalCount = globals.size();
+
+    // Blocks that read each global name before assigning it, and blocks that assign it
+    vector<vector<size_t>> useBlocks(globalCount), defBlocks(globalCount);
+    vector<size_t> usedIn(globalCount, SIZE_MAX), assignedIn(globalCount, SIZE_MAX);   // last block recorded
+    for (size_t b : cfg.order) {
+        for (size_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+            for (size_t use = ssa.firstUse[i]; use < ssa.firstUse[i + 1]; use++) {
+                size_t v = ssa.uses[use];
+                size_t g = v == SIZE_MAX ? SIZE_MAX : globalOf[v];
+                if (g == SIZE_MAX || assignedIn[g] == b || usedIn[g] == b) continue;
+                usedIn[g] = b;
+                useBlocks[g].push_back(b);
+            }
+            size_t g = defVariable[i] == SIZE_MAX ? SIZE_MAX : globalOf[defVariable[i]];
+            if (g != SIZE_MAX && assignedIn[g] != b) {
+                assignedIn[g] = b;
+                defBlocks[g].push_back(b);
+            }
+        }
+    }
+
+    // One name at a time: liveness walks back from the blocks that read it until blocks that
+    // assign it, so it costs the name's live range, and phis then go on the iterated frontiers
+    // of its assignments where it is live
+    vector<vector<size_t>> frontiers = globalCount > 0 ? cfg.dominanceFrontiers() : vector<vector<size_t>>();
+    vector<size_t> liveIn(blockCount, SIZE_MAX), assigns(blockCount, SIZE_MAX);
+    vector<size_t> placed(blockCount, SIZE_MAX), queued(blockCount, SIZE_MAX);
+    vector<size_t> worklist;
+    for (size_t g = 0; g < globalCount; g++) {
+        for (size_t b : defBlocks[g]) assigns[b] = g;
+        for (size_t b : useBlocks[g]) {
+            liveIn[b] = g;
+            worklist.push_back(b);
+        }
+        while (!worklist.empty()) {
+            size_t b = worklist.back();
+            worklist.pop_back();
+            for (size_t pred : cfg.blocks[b].preds) {
+                if (liveIn[pred] == g || assigns[pred] == g) continue;
+                liveIn[pred] = g;
+                worklist.push_back(pred);
+            }
+        }
+
+        worklist = std::move(defBlocks[g]);
+        for (size_t b : worklist) queued[b] = g;
+        while (!worklist.empty()) {
+            size_t b = worklist.back();
+            worklist.pop_back();
+            for (size_t frontier : frontiers[b]) {
+                if (placed[frontier] == g || liveIn[frontier] != g) continue;
+                placed[frontier] = g;
+                TACSSAValue phi;
+                phi.kind = TACSSAValue::PHI;
+                phi.variable = globals[g];
+                phi.at = frontier;
+                phi.operands.assign(cfg.blocks[frontier].preds.size() + (frontier == 0 ? 1 : 0), SIZE_MAX);
+                ssa.phis[frontier].push_back(ssa.values.size());
+                ssa.values.push_back(std::move(phi));
+                if (queued[frontier] != g) {
+                    queued[frontier] = g;
+                    worklist.push_back(frontier);
+                }
+            }
+        }
+    }
+
+    // Renaming: the current value of every name, with a log of what each def replaced so the
+    // walk can restore it when it leaves a block
+    vector<size_t> current(variableCount, SIZE_MAX);
+    vector<size_t> entryValue(variableCount, SIZE_MAX);
+    vector<pair<size_t, size_t>> replaced;   // name, its previous value
+    auto valueOf = [&](size_t v) {
+        if (current[v] != SIZE_MAX) return current[v];
+        if (entryValue[v] == SIZE_MAX) {
+            entryValue[v] = ssa.values.size();
+            TACSSAValue entry;
+            entry.variable = v;
+            ssa.values.push_back(std::move(entry));
+        }
+        return entryValue[v];
+    };
+    auto define = [&](size_t v, size_t value) {
+        replaced.push_back({v, current[v]});
+        current[v] = value;
+    };
+
+    vector<vector<size_t>> children(blockCount);
+    for (size_t b : cfg.order) {
+        if (b != 0) children[cfg.blocks[b].idom].push_back(b);
+    }
+    vector<pair<size_t, size_t>> walk = {{0, 0}};   // block, size of `replaced` when it was entered
+    vector<bool> visited(blockCount, false);
+    while (!walk.empty()) {
+        auto [b, mark] = walk.back();
+        if (visited[b]) {
+            walk.pop_back();
+            for (; replaced.size() > mark; replaced.pop_back()) current[replaced.back().first] = replaced.back().second;
+            continue;
+        }
+        visited[b] = true;
+        for (size_t phi : ssa.phis[b]) define(ssa.values[phi].variable, phi);
+        for (size_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+            for (size_t use = ssa.firstUse[i]; use < ssa.firstUse[i + 1]; use++) {
+                if (ssa.uses[use] != SIZE_MAX) ssa.uses[use] = valueOf(ssa.uses[use]);
+            }
+            size_t v = defVariable[i];
+            if (v == SIZE_MAX) continue;
+            ssa.defOf[i] = ssa.values.size();
+            TACSSAValue def;
+            def.kind = TACSSAValue::DEF;
+            def.variable = v;
+            def.at = i;
+            ssa.values.push_back(std::move(def));
+            define(v, ssa.defOf[i]);
+        }
+        for (size_t succ : cfg.blocks[b].succs) {
+            const vector<size_t>& preds = cfg.blocks[succ].preds;
+            size_t slot = find(preds.begin(), preds.end(), b) - preds.begin();
+            for (size_t phi : ssa.phis[succ]) {
+                size_t incoming = valueOf(ssa.values[phi].variable);
+                ssa.values[phi].operands[slot] = incoming;
+            }
+        }
+        for (auto child = children[b].rbegin(); child != children[b].rend(); ++child) {
+            walk.push_back({*child, replaced.size()});
+        }
+    }
+    for (size_t phi : ssa.phis[0]) {
+        size_t entry = valueOf(ssa.values[phi].variable);
+        ssa.values[phi].operands.back() = entry;
+    }
+    return ssa;
+}
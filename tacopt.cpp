@@ -0,0 +1,2092 @@
+#include "compiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+// === TAC Optimizer ===
+// Runs on the generated TAC before it is written, so the LLVM backend has fewer lines to parse,
+// build and verify, and the -O0 JIT path runs fewer instructions. Each function is optimized on
+// its own, relying on two properties of TACGenerator output: temporaries (t0, t1, ...) are
+// assigned exactly once, and a local only changes through an assignment naming it (there are
+// no globals or pointers, so calls cannot touch the caller's variables).
+//
+// - constant folding: operators, conditional jumps and switches whose operands are all
+//   constants, with the TAC backend's semantics (32-bit wrapping ints, bitwise && and ||)
+// - constant and copy propagation: a temporary's constant or copied temporary everywhere in the
+//   function; a local's known value until the next label or until either side is reassigned
+// - dead code elimination: assignments to temporaries and locals that are never read, and
+//   statements between an unconditional jump and the next label
+// - inlining of small leaf functions, callees first (see Inliner)
+// - self tail calls turned into jumps back to the top of the function (see eliminateTailRecursion)
+// - global constant propagation, value numbering and dead code elimination on the SSA form
+//   (see SSAOptimizer)
+// - loop-invariant code motion and strength reduction of induction variables (see LoopOptimizer)
+
+// Quote-aware split of a call's argument list: commas and parentheses inside string and char
+// literals belong to the literal
+vector<string> splitTACArguments(const string& argsStr) {
+    vector<string> args;
+    string current;
+    char quote = 0;
+    for (size_t i = 0; i < argsStr.size(); i++) {
+        char c = argsStr[i];
+        if (quote) {
+            current += c;
+            if (c == '\\' && i + 1 < argsStr.size()) {
+                current += argsStr[++i];
+            } else if (c == quote) {
+                quote = 0;
+            }
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+            current += c;
+        } else if (c == ',') {
+            args.push_back(current);
+            current.clear();
+        } else {
+            current += c;
+        }
+    }
+    args.push_back(current);
+
+    for (auto& arg : args) {
+        arg.erase(0, arg.find_first_not_of(" \t"));
+        arg.erase(arg.find_last_not_of(" \t") + 1);
+    }
+    if (args.size() == 1 && args[0].empty()) args.clear();
+    return args;
+}
+
+namespace {
+
+// One parsed TAC statement. Operands stay as TAC text so a statement can be printed back
+// exactly in the form TACExecutor parses.
+struct TACInstr {
+    enum Kind { LABEL, ASSIGN, CALL, IF_GOTO, GOTO, SWITCH, RETURN, OTHER };
+
+    Kind kind = OTHER;
+    string indent;
+    string text;          // the line as written, printed again as long as nothing changed
+    string type;          // ASSIGN: declared type, empty for a plain assignment
+    string dest;          // ASSIGN
+    string op;            // ASSIGN: "" copy, "call", unary or binary operator; IF_GOTO: comparison
+    string callee;        // CALL and ASSIGN with op "call"
+    vector<string> args;  // operands
+    string label;         // LABEL, GOTO, IF_GOTO; SWITCH: the default target
+    vector<pair<int32_t, string>> cases;  // SWITCH: case value and target, in order
+    bool negated = false;                 // IF_GOTO written as ifFalse: jumps when the comparison fails
+    bool changed = false;
+    bool removed = false;
+};
+
+// A compile-time value of a TAC operand
+struct Constant {
+    VarType type = VarType::UNKNOWN;
+    int32_t i = 0;    // INT, BOOL, CHAR
+    double d = 0;     // DOUBLE
+};
+
+// Searched in this order, like TACExecutor::processBinaryOp, so "a <= b" splits at "<="
+const char* const binaryOperators[] = {
+    " << ", " >> ", " == ", " != ", " <= ", " >= ", " < ", " > ", " && ", " || ",
+    " & ", " | ", " ^ ", " + ", " - ", " * ", " / ", " % "
+};
+
+struct OptimizerStats {
+    int folded = 0;
+    int propagated = 0;
+    int removed = 0;
+    int inlined = 0;
+    int tailCalls = 0;
+    int hoisted = 0;
+    int reduced = 0;
+    int redundant = 0;
+};
+
+string_view trim(string_view s) {
+    size_t start = s.find_first_not_of(" \t");
+    if (start == string_view::npos) return {};
+    return s.substr(start, s.find_last_not_of(" \t") - start + 1);
+}
+
+bool startsWith(string_view s, string_view prefix) {
+    return s.compare(0, prefix.size(), prefix) == 0;
+}
+
+VarType parseTypeName(const string& name) {
+    if (name == "int") return VarType::INT;
+    if (name == "float") return VarType::FLOAT;
+    if (name == "double") return VarType::DOUBLE;
+    if (name == "char") return VarType::CHAR;
+    if (name == "string") return VarType::STRING;
+    if (name == "bool") return VarType::BOOL;
+    if (name == "void") return VarType::VOID;
+    return VarType::UNKNOWN;
+}
+
+// bool is an i32 in both backends, so it mixes freely with int
+bool isIntLike(VarType type) {
+    return type == VarType::INT || type == VarType::BOOL;
+}
+
+bool sameRepresentation(VarType a, VarType b) {
+    return a == b || (isIntLike(a) && isIntLike(b));
+}
+
+bool isStringLiteral(const string& s) {
+    return s.size() >= 2 && s[0] == '"' && s.back() == '"';
+}
+
+bool isCharLiteral(const string& s) {
+    return s.size() >= 2 && s[0] == '\'' && s.back() == '\'';
+}
+
+bool isTempName(const string& s) {
+    return s.size() > 1 && s[0] == 't' && s.find_first_not_of("0123456789", 1) == string::npos;
+}
+
+// Literals the way TACExecutor::getValueWithType reads them. Float-suffixed literals and
+// non-finite or out-of-range numbers are left alone.
+bool parseConstant(const string& s, Constant& value) {
+    if (s.empty()) return false;
+    if (s == "true" || s == "false") {
+        value = {VarType::BOOL, s == "true" ? 1 : 0, 0};
+        return true;
+    }
+    if (isCharLiteral(s)) {
+        if (s.size() != 3) return false;
+        value = {VarType::CHAR, static_cast<signed char>(s[1]), 0};
+        return true;
+    }
+    bool numeric = isdigit(static_cast<unsigned char>(s[0])) ||
+                   (s[0] == '-' && s.size() > 1 && isdigit(static_cast<unsigned char>(s[1])));
+    if (!numeric) return false;
+
+    char* end = nullptr;
+    if (s.find_first_of(".eE") != string::npos) {
+        double d = strtod(s.c_str(), &end);
+        if (*end != '\0' || !isfinite(d)) return false;
+        value = {VarType::DOUBLE, 0, d};
+        return true;
+    }
+    if (s.find_first_not_of("-0123456789") != string::npos) return false;
+    long long i = strtoll(s.c_str(), &end, 10);
+    if (*end != '\0' || i < INT32_MIN || i > INT32_MAX) return false;
+    value = {VarType::INT, static_cast<int32_t>(i), 0};
+    return true;
+}
+
+string formatConstant(const Constant& value) {
+    switch (value.type) {
+        case VarType::DOUBLE: {
+            // %.17g round-trips; a '.' keeps whole values from reading back as ints
+            char buffer[32];
+            snprintf(buffer, sizeof(buffer), "%.17g", value.d);
+            string text = buffer;
+            if (text.find_first_of(".e") == string::npos) text += ".0";
+            return text;
+        }
+        case VarType::CHAR:
+            return string("'") + static_cast<char>(value.i) + "'";
+        default:
+            return to_string(value.i);
+    }
+}
+
+// The value a variable of type `to` holds after TACExecutor::convertToType stores `value` in it
+bool convertConstant(const Constant& value, VarType to, Constant& result) {
+    if (sameRepresentation(value.type, to) || value.type == to) {
+        result = value;
+        result.type = to;
+        return true;
+    }
+    if (isIntLike(value.type) && to == VarType::DOUBLE) {
+        result = {VarType::DOUBLE, 0, static_cast<double>(value.i)};
+        return true;
+    }
+    if (value.type == VarType::DOUBLE && isIntLike(to)) {
+        // fptosi of an out-of-range value is poison, so only the well-defined cases fold
+        if (!(value.d > INT32_MIN - 1.0 && value.d < INT32_MAX + 1.0)) return false;
+        result = {to, static_cast<int32_t>(value.d), 0};
+        return true;
+    }
+    return false;
+}
+
+bool isComparison(const string& op) {
+    return op == "==" || op == "!=" || op == "<" || op == ">" || op == "<=" || op == ">=";
+}
+
+template <typename T>
+bool compareValues(const string& op, T l, T r) {
+    if (op == "==") return l == r;
+    if (op == "!=") return l != r;
+    if (op == "<") return l < r;
+    if (op == ">") return l > r;
+    if (op == "<=") return l <= r;
+    return l >= r;
+}
+
+// TACExecutor::processBinaryOp on constants. Combinations the backend would reject or lower to
+// poison (char arithmetic, bitwise ops on doubles, division by zero, oversized shifts) stay put.
+bool foldBinary(const string& op, const Constant& l, const Constant& r, Constant& result) {
+    if (l.type == VarType::CHAR || r.type == VarType::CHAR) {
+        if (l.type != VarType::CHAR || r.type != VarType::CHAR || !isComparison(op)) return false;
+        result = {VarType::INT, compareValues(op, l.i, r.i) ? 1 : 0, 0};
+        return true;
+    }
+
+    if (l.type == VarType::DOUBLE || r.type == VarType::DOUBLE) {
+        double a = l.type == VarType::DOUBLE ? l.d : l.i;
+        double b = r.type == VarType::DOUBLE ? r.d : r.i;
+        if (isComparison(op)) {
+            result = {VarType::INT, compareValues(op, a, b) ? 1 : 0, 0};
+            return true;
+        }
+        double d;
+        if (op == "+") d = a + b;
+        else if (op == "-") d = a - b;
+        else if (op == "*") d = a * b;
+        else if (op == "/") d = a / b;
+        else return false;
+        if (!isfinite(d)) return false;
+        result = {VarType::DOUBLE, 0, d};
+        return true;
+    }
+
+    if (!isIntLike(l.type) || !isIntLike(r.type)) return false;
+    int32_t a = l.i, b = r.i;
+    uint32_t ua = static_cast<uint32_t>(a), ub = static_cast<uint32_t>(b);
+    int32_t value;
+    if (isComparison(op)) value = compareValues(op, a, b) ? 1 : 0;
+    else if (op == "+") value = static_cast<int32_t>(ua + ub);
+    else if (op == "-") value = static_cast<int32_t>(ua - ub);
+    else if (op == "*") value = static_cast<int32_t>(ua * ub);
+    else if (op == "/" || op == "%") {
+        if (b == 0 || (a == INT32_MIN && b == -1)) return false;
+        value = op == "/" ? a / b : a % b;
+    }
+    else if (op == "<<" || op == ">>") {
+        if (b < 0 || b > 31) return false;
+        value = op == "<<" ? static_cast<int32_t>(ua << b) : a >> b;
+    }
+    // The TAC backend lowers && and || to bitwise and/or of the operand values
+    else if (op == "&" || op == "&&") value = a & b;
+    else if (op == "|" || op == "||") value = a | b;
+    else if (op == "^") value = a ^ b;
+    else return false;
+    result = {VarType::INT, value, 0};
+    return true;
+}
+
+bool foldUnary(const string& op, const Constant& operand, Constant& result) {
+    if (op == "-" && isIntLike(operand.type)) {
+        result = {operand.type, static_cast<int32_t>(0u - static_cast<uint32_t>(operand.i)), 0};
+        return true;
+    }
+    if (op == "-" && operand.type == VarType::DOUBLE) {
+        result = {VarType::DOUBLE, 0, -operand.d};
+        return true;
+    }
+    // `!` is a bitwise not of the i32 in the TAC backend
+    if (op == "!" && isIntLike(operand.type)) {
+        result = {VarType::INT, ~operand.i, 0};
+        return true;
+    }
+    return false;
+}
+
+// Whether a conditional jump on constant operands is taken; the comparison is the one
+// processBinaryOp makes
+bool foldCondition(const TACInstr& instr, const Constant& l, const Constant& r, bool& taken) {
+    Constant result;
+    if (!foldBinary(instr.op, l, r, result)) return false;
+    taken = (result.i != 0) != instr.negated;
+    return true;
+}
+
+// Target of a switch on a constant operand, compared like the backend does: chars by their
+// unsigned code, everything else converted to int
+bool foldSwitch(const TACInstr& instr, const Constant& value, string& target) {
+    int32_t key;
+    Constant converted;
+    if (value.type == VarType::CHAR) key = static_cast<unsigned char>(value.i);
+    else if (convertConstant(value, VarType::INT, converted)) key = converted.i;
+    else return false;
+    target = instr.label;
+    for (const auto& [caseValue, label] : instr.cases) {
+        if (caseValue == key) {
+            target = label;
+            break;
+        }
+    }
+    return true;
+}
+
+// A conditional jump or switch on constant operands becomes a goto, or disappears when it never
+// jumps; false if the operands are not constant
+bool foldJump(TACInstr& instr) {
+    if (instr.kind == TACInstr::IF_GOTO) {
+        Constant l, r;
+        bool taken;
+        if (!parseConstant(instr.args[0], l) || !parseConstant(instr.args[1], r) ||
+            !foldCondition(instr, l, r, taken)) return false;
+        if (!taken) {
+            instr.removed = true;
+            return true;
+        }
+    } else if (instr.kind == TACInstr::SWITCH) {
+        Constant value;
+        string target;
+        if (!parseConstant(instr.args[0], value) || !foldSwitch(instr, value, target)) return false;
+        instr.label = target;
+        instr.cases.clear();
+    } else {
+        return false;
+    }
+    instr.kind = TACInstr::GOTO;
+    instr.args.clear();
+    instr.op.clear();
+    instr.negated = false;
+    instr.changed = true;
+    return true;
+}
+
+// === Parsing and Printing ===
+
+bool parseCall(string_view text, string& callee, vector<string>& args) {
+    size_t open = text.find('(');
+    size_t close = text.rfind(')');
+    if (open == string_view::npos || close == string_view::npos || close < open) return false;
+    callee = string(trim(text.substr(0, open)));
+    args = splitTACArguments(string(text.substr(open + 1, close - open - 1)));
+    return true;
+}
+
+// Mirrors the statement dispatch in TACExecutor::processStatement; instr.text holds the line
+void parseInstr(TACInstr& instr) {
+    string_view line = instr.text;
+    string_view stmt = trim(line);
+    if (stmt.empty() || startsWith(stmt, "//")) return;
+    instr.indent = string(line.substr(0, stmt.data() - line.data()));
+
+    if (stmt.back() == ':') {
+        instr.kind = TACInstr::LABEL;
+        instr.label = string(stmt.substr(0, stmt.size() - 1));
+        return;
+    }
+
+    if (startsWith(stmt, "call ")) {
+        if (parseCall(stmt.substr(5), instr.callee, instr.args)) instr.kind = TACInstr::CALL;
+        return;
+    }
+
+    if (startsWith(stmt, "switch ")) {
+        size_t open = stmt.find(" [");
+        size_t close = stmt.rfind("] default ");
+        if (open == string_view::npos || close == string_view::npos || close < open) return;
+        string_view list = stmt.substr(open + 2, close - open - 2);
+        while (!list.empty()) {
+            size_t comma = list.find(", ");
+            string_view entry = list.substr(0, comma);
+            size_t colon = entry.find(": ");
+            if (colon == string_view::npos) return;
+            int32_t value = static_cast<int32_t>(strtol(string(entry.substr(0, colon)).c_str(), nullptr, 10));
+            instr.cases.push_back({value, string(entry.substr(colon + 2))});
+            list = comma == string_view::npos ? string_view() : list.substr(comma + 2);
+        }
+        instr.kind = TACInstr::SWITCH;
+        instr.args = {string(trim(stmt.substr(7, open - 7)))};
+        instr.label = string(trim(stmt.substr(close + 10)));
+        return;
+    }
+
+    size_t eqPos = stmt.find(" = ");
+    if (eqPos != string_view::npos) {
+        string_view lhs = trim(stmt.substr(0, eqPos));
+        string_view rhs = trim(stmt.substr(eqPos + 3));
+        if (rhs == "param" || rhs.empty()) return;
+
+        size_t space = lhs.find(' ');
+        if (space != string_view::npos) {
+            instr.type = string(lhs.substr(0, space));
+            instr.dest = string(trim(lhs.substr(space + 1)));
+        } else {
+            instr.dest = string(lhs);
+        }
+
+        instr.kind = TACInstr::ASSIGN;
+        if (startsWith(rhs, "call ")) {
+            if (!parseCall(rhs.substr(5), instr.callee, instr.args)) instr.kind = TACInstr::OTHER;
+            instr.op = "call";
+            return;
+        }
+        for (const char* pattern : binaryOperators) {
+            size_t pos = rhs.find(pattern);
+            if (pos != string_view::npos) {
+                size_t length = strlen(pattern);
+                instr.op = string(pattern + 1, length - 2);
+                instr.args = {string(trim(rhs.substr(0, pos))), string(trim(rhs.substr(pos + length)))};
+                return;
+            }
+        }
+        if ((rhs[0] == '-' || rhs[0] == '!') && rhs.size() > 1 && !isdigit(static_cast<unsigned char>(rhs[1]))) {
+            instr.op = string(1, rhs[0]);
+            instr.args = {string(trim(rhs.substr(1)))};
+        } else {
+            instr.args = {string(rhs)};
+        }
+        return;
+    }
+
+    size_t gotoPos = stmt.find(" goto ");
+    bool negated = startsWith(stmt, "ifFalse ");
+    if ((negated || startsWith(stmt, "if ")) && gotoPos != string_view::npos) {
+        size_t condStart = negated ? 8 : 3;
+        string_view condition = trim(stmt.substr(condStart, gotoPos - condStart));
+        for (const char* pattern : {" == ", " != ", " <= ", " >= ", " < ", " > "}) {
+            size_t pos = condition.find(pattern);
+            if (pos != string_view::npos) {
+                size_t length = strlen(pattern);
+                instr.kind = TACInstr::IF_GOTO;
+                instr.negated = negated;
+                instr.op = string(pattern + 1, length - 2);
+                instr.args = {string(trim(condition.substr(0, pos))), string(trim(condition.substr(pos + length)))};
+                instr.label = string(trim(stmt.substr(gotoPos + 6)));
+                break;
+            }
+        }
+        return;
+    }
+
+    if (startsWith(stmt, "goto ")) {
+        instr.kind = TACInstr::GOTO;
+        instr.label = string(trim(stmt.substr(5)));
+        return;
+    }
+
+    if (stmt == "return" || startsWith(stmt, "return ")) {
+        instr.kind = TACInstr::RETURN;
+        if (stmt.size() > 7) instr.args = {string(trim(stmt.substr(7)))};
+    }
+}
+
+string joinArguments(const vector<string>& args) {
+    string joined;
+    for (size_t i = 0; i < args.size(); i++) {
+        if (i > 0) joined += ", ";
+        joined += args[i];
+    }
+    return joined;
+}
+
+// Appends the statement's line; unchanged statements keep their original text
+void printInstr(const TACInstr& instr, string& out) {
+    if (!instr.changed) {
+        out += instr.text;
+        return;
+    }
+    out += instr.indent;
+    switch (instr.kind) {
+        case TACInstr::LABEL:
+            out += instr.label + ":";
+            break;
+        case TACInstr::CALL:
+            out += "call " + instr.callee + "(" + joinArguments(instr.args) + ")";
+            break;
+        case TACInstr::ASSIGN:
+            if (!instr.type.empty()) out += instr.type + " ";
+            out += instr.dest + " = ";
+            if (instr.op == "call") out += "call " + instr.callee + "(" + joinArguments(instr.args) + ")";
+            else if (instr.op.empty()) out += instr.args[0];
+            else if (instr.args.size() == 1) out += instr.op + instr.args[0];
+            else out += instr.args[0] + " " + instr.op + " " + instr.args[1];
+            break;
+        case TACInstr::IF_GOTO:
+            out += (instr.negated ? "ifFalse " : "if ") + instr.args[0] + " " + instr.op + " " + instr.args[1] + " goto " + instr.label;
+            break;
+        case TACInstr::GOTO:
+            out += "goto " + instr.label;
+            break;
+        case TACInstr::SWITCH:
+            out += "switch " + instr.args[0] + " [";
+            for (size_t i = 0; i < instr.cases.size(); i++) {
+                if (i > 0) out += ", ";
+                out += to_string(instr.cases[i].first) + ": " + instr.cases[i].second;
+            }
+            out += "] default " + instr.label;
+            break;
+        case TACInstr::RETURN:
+            out += instr.args.empty() ? "return" : "return " + instr.args[0];
+            break;
+        default:
+            out += instr.text.substr(instr.indent.size());
+            break;
+    }
+}
+
+// === Control Flow ===
+
+TACControl controlOf(const TACInstr& instr) {
+    TACControl control;
+    if (instr.removed) return control;
+    switch (instr.kind) {
+        case TACInstr::LABEL: control.kind = TACControl::LABEL; break;
+        case TACInstr::GOTO: control.kind = TACControl::GOTO; break;
+        case TACInstr::IF_GOTO: control.kind = TACControl::BRANCH; break;
+        case TACInstr::SWITCH:
+            control.kind = TACControl::SWITCH;
+            for (const auto& entry : instr.cases) control.cases.push_back(entry.second);
+            break;
+        case TACInstr::RETURN: control.kind = TACControl::RETURN; break;
+        default: return control;
+    }
+    control.label = instr.label;
+    return control;
+}
+
+// Removed statements count as plain ones; the graph's label keys view the body's labels
+TACControlFlowGraph buildFlowGraph(const vector<TACInstr>& body) {
+    vector<TACControl> controls;
+    controls.reserve(body.size());
+    for (const TACInstr& instr : body) controls.push_back(controlOf(instr));
+    return buildTACControlFlowGraph(controls);
+}
+
+// === Function Optimizer ===
+
+// One instance serves every function of a program, so the tables below keep their buckets
+class FunctionOptimizer {
+private:
+    vector<TACInstr>* body = nullptr;
+    const unordered_map<string, VarType>& returnTypes;
+    OptimizerStats& stats;
+
+    unordered_map<string, VarType> varTypes;    // locals and parameters: type of the first declaration
+    unordered_set<string> temps;                  // t<N> names assigned exactly once
+    unordered_map<string, VarType> tempTypes;
+
+    // Propagation state of the current forward pass. tempValues are constants or temporaries
+    // and hold for the whole function; localValues only until a label that can be jumped to.
+    unordered_map<string, string> tempValues;
+    unordered_map<string, string> localValues;
+    unordered_map<string, int> counts;          // assignments while collecting names, reads in DCE
+
+    // Result type of an assignment's right-hand side, as TACExecutor::processAssignment infers it
+    VarType resultType(const TACInstr& instr) const {
+        if (instr.op.empty()) return typeOf(instr.args[0]);
+        if (instr.op == "call") {
+            auto it = returnTypes.find(instr.callee);
+            return it != returnTypes.end() && it->second != VarType::VOID ? it->second : VarType::UNKNOWN;
+        }
+        if (instr.op == "!") return VarType::INT;
+        if (instr.args.size() == 1) return typeOf(instr.args[0]);
+
+        VarType l = typeOf(instr.args[0]), r = typeOf(instr.args[1]);
+        if (isComparison(instr.op)) return VarType::INT;
+        if (l == VarType::UNKNOWN || r == VarType::UNKNOWN || l == VarType::CHAR || r == VarType::CHAR ||
+            l == VarType::STRING || r == VarType::STRING) return VarType::UNKNOWN;
+        if (instr.op == "+" || instr.op == "-" || instr.op == "*" || instr.op == "/") {
+            if (l == VarType::DOUBLE || r == VarType::DOUBLE) return VarType::DOUBLE;
+            if (l == VarType::FLOAT || r == VarType::FLOAT) return VarType::FLOAT;
+        }
+        return VarType::INT;
+    }
+
+    // Parameters and typed declarations fix a local's type; temporaries are the t<N> names that
+    // are assigned once and never declared
+    void collectNames(const vector<pair<string, VarType>>& params) {
+        for (const auto& [name, type] : params) varTypes.emplace(name, type);
+
+        for (const TACInstr& instr : *body) {
+            if (instr.kind != TACInstr::ASSIGN) continue;
+            counts[instr.dest]++;
+            if (varTypes.count(instr.dest)) continue;
+            if (!instr.type.empty()) varTypes[instr.dest] = parseTypeName(instr.type);
+            else if (!isTempName(instr.dest)) varTypes[instr.dest] = VarType::UNKNOWN;
+        }
+        for (const auto& [name, count] : counts) {
+            if (count == 1 && isTempName(name) && !varTypes.count(name)) temps.insert(name);
+        }
+    }
+
+    // Replaces an operand with its known value. Strings are only substituted where the backend
+    // splits quote-aware (call arguments and returns).
+    void substitute(TACInstr& instr, string& operand, bool allowString) {
+        const string* value = &operand;
+        for (int depth = 0; depth < 8; depth++) {
+            auto it = tempValues.find(*value);
+            if (it == tempValues.end()) {
+                it = localValues.find(*value);
+                if (it == localValues.end()) break;
+            }
+            if (isStringLiteral(it->second) && !allowString) break;
+            value = &it->second;
+        }
+        if (value != &operand) {
+            operand = *value;
+            instr.changed = true;
+            stats.propagated++;
+        }
+    }
+
+    // `name` was just assigned: facts about it, and facts that copied it, no longer hold
+    void kill(const string& name) {
+        localValues.erase(name);
+        for (auto it = localValues.begin(); it != localValues.end();) {
+            if (it->second == name) it = localValues.erase(it);
+            else ++it;
+        }
+    }
+
+    void recordAssignment(const TACInstr& instr) {
+        kill(instr.dest);
+
+        if (temps.count(instr.dest)) {
+            VarType type = resultType(instr);
+            tempTypes[instr.dest] = type;
+            if (!instr.op.empty() || type == VarType::FLOAT || type == VarType::UNKNOWN) return;
+            const string& source = instr.args[0];
+            Constant value;
+            if (parseConstant(source, value) || temps.count(source)) tempValues[instr.dest] = source;
+            else if (varTypes.count(source)) localValues[instr.dest] = source;
+            return;
+        }
+
+        auto var = varTypes.find(instr.dest);
+        if (var == varTypes.end() || !instr.op.empty()) return;
+        VarType type = var->second;
+        if (type == VarType::FLOAT || type == VarType::UNKNOWN) return;
+        if (!instr.type.empty() && parseTypeName(instr.type) != type) return;
+
+        const string& source = instr.args[0];
+        Constant value, converted;
+        if (parseConstant(source, value)) {
+            // A declaration converts its initializer; a plain assignment stores it as is
+            if (!instr.type.empty() ? convertConstant(value, type, converted)
+                                    : sameRepresentation(value.type, type) && convertConstant(value, type, converted)) {
+                localValues[instr.dest] = formatConstant(converted);
+            }
+        } else if (isStringLiteral(source)) {
+            if (type == VarType::STRING) localValues[instr.dest] = source;
+        } else if (source != instr.dest && sameRepresentation(typeOf(source), type)) {
+            localValues[instr.dest] = source;
+        }
+    }
+
+    void foldAssignment(TACInstr& instr) {
+        if (instr.op.empty() || instr.op == "call") return;
+        Constant l, r, result;
+        bool folded = instr.args.size() == 1
+            ? parseConstant(instr.args[0], l) && foldUnary(instr.op, l, result)
+            : parseConstant(instr.args[0], l) && parseConstant(instr.args[1], r) && foldBinary(instr.op, l, r, result);
+        if (!folded) {
+            simplifyIdentity(instr);
+            return;
+        }
+        instr.op.clear();
+        instr.args = {formatConstant(result)};
+        instr.changed = true;
+        stats.folded++;
+    }
+
+    // x * 0, x * 1, x + 0 and x - 0 on ints, e.g. the start value of a reduced induction variable
+    void simplifyIdentity(TACInstr& instr) {
+        if (instr.args.size() != 2) return;
+        for (int side = 0; side < 2; side++) {
+            Constant c;
+            const string& other = instr.args[1 - side];
+            if (!parseConstant(instr.args[side], c) || c.type != VarType::INT || typeOf(other) != VarType::INT) continue;
+            string value;
+            if (instr.op == "*" && c.i == 0) value = "0";
+            else if (instr.op == "*" && c.i == 1) value = other;
+            else if (instr.op == "+" && c.i == 0) value = other;
+            else if (instr.op == "-" && c.i == 0 && side == 1) value = other;
+            else continue;
+            instr.op.clear();
+            instr.args = {value};
+            instr.changed = true;
+            stats.folded++;
+            return;
+        }
+    }
+
+    void remove(TACInstr& instr) {
+        instr.removed = true;
+        stats.removed++;
+    }
+
+    // Forward pass: propagation, folding, and dropping statements no path reaches. Temporaries
+    // are defined before they are used and locals are only tracked within a block, so a single
+    // pass finds everything.
+    void propagate() {
+        TACControlFlowGraph cfg = buildFlowGraph(*body);
+        bool reachable = true;
+
+        for (size_t i = 0; i < body->size(); i++) {
+            TACInstr& instr = (*body)[i];
+            if (instr.removed || instr.kind == TACInstr::OTHER) continue;
+            if (instr.kind == TACInstr::LABEL) {
+                // Values still hold when the only way in is from the block just before
+                const TACBlock& block = cfg.blocks[cfg.blockOf[i]];
+                if (block.preds.size() != 1 || block.preds[0] + 1 != cfg.blockOf[i]) localValues.clear();
+                reachable = block.reachable;
+                continue;
+            }
+            if (!reachable) {
+                remove(instr);
+                continue;
+            }
+
+            switch (instr.kind) {
+                case TACInstr::ASSIGN:
+                    for (string& arg : instr.args) substitute(instr, arg, instr.op == "call");
+                    foldAssignment(instr);
+                    recordAssignment(instr);
+                    break;
+                case TACInstr::CALL:
+                    for (string& arg : instr.args) substitute(instr, arg, true);
+                    break;
+                case TACInstr::IF_GOTO:
+                    substitute(instr, instr.args[0], false);
+                    substitute(instr, instr.args[1], false);
+                    if (!foldJump(instr)) break;
+                    stats.folded++;
+                    if (!instr.removed) reachable = false;
+                    break;
+                case TACInstr::GOTO:
+                    reachable = false;
+                    break;
+                case TACInstr::SWITCH:
+                    substitute(instr, instr.args[0], false);
+                    if (foldJump(instr)) stats.folded++;
+                    reachable = false;
+                    break;
+                case TACInstr::RETURN:
+                    for (string& arg : instr.args) substitute(instr, arg, true);
+                    reachable = false;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    // Assignments nobody reads: pure ones go away, calls are kept for their effects. Removing
+    // one drops the reads of its operands, so the walk runs backwards (a use comes after its
+    // definition) and repeats only when a loop carried a read past the definition.
+    void removeDeadAssignments() {
+        unordered_map<string, int>& reads = counts;
+        reads.clear();
+        for (const TACInstr& instr : *body) {
+            if (instr.removed) continue;
+            for (const string& arg : instr.args) reads[arg]++;
+        }
+
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (auto it = body->rbegin(); it != body->rend(); ++it) {
+                TACInstr& instr = *it;
+                if (instr.removed || instr.kind != TACInstr::ASSIGN) continue;
+                bool selfCopy = instr.op.empty() && instr.type.empty() && instr.args[0] == instr.dest;
+                if (reads[instr.dest] > 0 && !selfCopy) continue;
+
+                if (instr.op == "call") {
+                    // Still a call, now without a result; its arguments stay read
+                    instr.kind = TACInstr::CALL;
+                    instr.type.clear();
+                    instr.dest.clear();
+                    instr.op.clear();
+                    instr.changed = true;
+                    stats.removed++;
+                } else {
+                    for (const string& arg : instr.args) {
+                        if (--reads[arg] == 0) changed = true;
+                    }
+                    remove(instr);
+                }
+            }
+        }
+    }
+
+public:
+    FunctionOptimizer(const unordered_map<string, VarType>& functionReturnTypes, OptimizerStats& optimizerStats)
+        : returnTypes(functionReturnTypes), stats(optimizerStats) {}
+
+    // Type of an operand as of the last run: literals, typed locals and temporaries
+    VarType typeOf(const string& operand) const {
+        Constant value;
+        if (parseConstant(operand, value)) return value.type;
+        if (isStringLiteral(operand)) return VarType::STRING;
+        auto temp = tempTypes.find(operand);
+        if (temp != tempTypes.end()) return temp->second;
+        auto var = varTypes.find(operand);
+        return var != varTypes.end() ? var->second : VarType::UNKNOWN;
+    }
+
+    void run(vector<TACInstr>& instrs, const vector<pair<string, VarType>>& params) {
+        body = &instrs;
+        varTypes.clear();
+        temps.clear();
+        tempTypes.clear();
+        tempValues.clear();
+        localValues.clear();
+        counts.clear();
+        collectNames(params);
+        propagate();
+        removeDeadAssignments();
+    }
+};
+
+// === SSA Optimizer ===
+// Global passes over the function's SSA form (buildTACSSA). The statements stay as they are; the
+// form only says which value every operand reads, so the passes see through joins and loops
+// where FunctionOptimizer forgets a local at the next jump target. One construction serves all
+// three; it costs the statements plus the blocks each name is live in, and each pass is then
+// linear in the statements and values (SCCP lowers every value at most twice):
+//
+// - sparse conditional constant propagation (Wegman and Zadeck): values that are constant on
+//   every executable path replace their uses, and jumps they decide become gotos
+// - global value numbering over the dominator tree: a pure expression a temporary already holds
+//   becomes a copy of it. The temporary must also come first in the text, as TACExecutor
+//   lowers blocks in that order.
+// - dead code elimination by marking: an assignment stays only if its value reaches a call,
+//   jump or return, so variables that only feed each other around a loop go too
+
+class SSAOptimizer {
+private:
+    enum State { UNDEFINED, CONSTANT, VARYING };
+    struct Cell {
+        State state = UNDEFINED;
+        Constant value;
+    };
+
+    vector<TACInstr>* body = nullptr;
+    const FunctionOptimizer* types = nullptr;
+    OptimizerStats& stats;
+
+    TACControlFlowGraph cfg;
+    TACSSAForm ssa;
+    vector<TACDefUse> defUses;              // kept between functions for their capacity
+    vector<bool> reassigned;                // per SSA variable: a temporary assigned more than once
+
+    // Constant propagation state
+    vector<Cell> cells;
+    vector<bool> executable;               // per block
+    vector<vector<bool>> executableEdges;  // per block, parallel to its preds
+    vector<size_t> blockWork;
+    vector<size_t> valueWork;
+    struct Reader {
+        bool phi;                           // phis[index] or statement index
+        size_t index;
+    };
+    vector<Reader> readers;                 // of every value, grouped by value
+    vector<size_t> firstReader;             // per value, and one past the last
+
+    // Value numbering: expression -> temporary holding it, within the current dominator subtree
+    struct Leader {
+        string name;
+        size_t value;
+        size_t statement;
+    };
+    unordered_map<string, Leader> leaders;
+
+    void build() {
+        cfg = buildFlowGraph(*body);
+        defUses.resize(body->size());
+        for (size_t i = 0; i < body->size(); i++) {
+            const TACInstr& instr = (*body)[i];
+            TACDefUse& statement = defUses[i];
+            statement.def = {};
+            statement.uses.clear();
+            if (instr.removed) continue;
+            for (const string& arg : instr.args) statement.uses.push_back(arg);
+            if (instr.kind != TACInstr::ASSIGN) continue;
+            statement.def = instr.dest;
+        }
+        ssa = buildTACSSA(cfg, defUses);
+
+        vector<int> definitions(ssa.variables.size(), 0);
+        for (const TACSSAValue& value : ssa.values) {
+            if (value.kind == TACSSAValue::DEF) definitions[value.variable]++;
+        }
+        reassigned.assign(ssa.variables.size(), false);
+        for (size_t v = 0; v < ssa.variables.size(); v++) {
+            reassigned[v] = definitions[v] > 1 && isTempName(ssa.variables[v]);
+        }
+    }
+
+    // A temporary assigned more than once is not a plain SSA value in TACExecutor either
+    bool isReassignedTemp(size_t value) const {
+        return value != SIZE_MAX && reassigned[ssa.values[value].variable];
+    }
+
+    static bool sameConstant(const Constant& a, const Constant& b) {
+        return a.type == b.type && a.i == b.i && memcmp(&a.d, &b.d, sizeof(double)) == 0;
+    }
+
+    Cell operandCell(size_t statement, size_t use) const {
+        size_t value = ssa.useOf(statement, use);
+        if (value != SIZE_MAX) return cells[value];
+        Cell cell;
+        cell.state = parseConstant((*body)[statement].args[use], cell.value) ? CONSTANT : VARYING;
+        return cell;
+    }
+
+    // The value an assignment stores, with the conversions FunctionOptimizer::recordAssignment
+    // relies on; floats, strings and calls are never constant
+    Cell evaluateDef(size_t statement) const {
+        const TACInstr& instr = (*body)[statement];
+        Cell result;
+        result.state = VARYING;
+        if (instr.op == "call" || isReassignedTemp(ssa.defOf[statement])) return result;
+
+        vector<Constant> operands;
+        for (size_t k = 0; k < instr.args.size(); k++) {
+            Cell cell = operandCell(statement, k);
+            if (cell.state != CONSTANT) {
+                result.state = cell.state;
+                if (cell.state == VARYING) return result;
+            }
+            operands.push_back(cell.value);
+        }
+        if (result.state == UNDEFINED) return result;
+
+        Constant value;
+        bool folded = instr.op.empty() ? (value = operands[0], true)
+                    : operands.size() == 1 ? foldUnary(instr.op, operands[0], value)
+                    : foldBinary(instr.op, operands[0], operands[1], value);
+        if (!folded) return result;
+
+        if (isTempName(instr.dest) && instr.type.empty()) {
+            result.value = value;
+        } else {
+            VarType type = types->typeOf(instr.dest);
+            if (type == VarType::FLOAT || type == VarType::STRING || type == VarType::UNKNOWN) return result;
+            if (!instr.type.empty() && parseTypeName(instr.type) != type) return result;
+            // A declaration converts its initializer; a plain assignment stores it as is
+            if (instr.type.empty() && !sameRepresentation(value.type, type)) return result;
+            if (!convertConstant(value, type, result.value)) return result;
+        }
+        result.state = CONSTANT;
+        return result;
+    }
+
+    Cell evaluatePhi(size_t phi) const {
+        const TACSSAValue& value = ssa.values[phi];
+        Cell result;
+        for (size_t slot = 0; slot < value.operands.size(); slot++) {
+            // The entry block's last operand is the value on entry to the function
+            bool incoming = slot < executableEdges[value.at].size() ? executableEdges[value.at][slot] : true;
+            if (!incoming) continue;
+            const Cell& cell = cells[value.operands[slot]];
+            if (cell.state == UNDEFINED) continue;
+            if (cell.state == VARYING || (result.state == CONSTANT && !sameConstant(result.value, cell.value))) {
+                result.state = VARYING;
+                return result;
+            }
+            result = cell;
+        }
+        return result;
+    }
+
+    void lower(size_t value, const Cell& cell) {
+        Cell& current = cells[value];
+        if (current.state == VARYING || cell.state == UNDEFINED) return;
+        if (current.state == CONSTANT && cell.state == CONSTANT && sameConstant(current.value, cell.value)) return;
+        current.state = current.state == CONSTANT ? VARYING : cell.state;
+        current.value = cell.value;
+        valueWork.push_back(value);
+    }
+
+    void markEdge(size_t from, size_t to) {
+        if (to >= cfg.blocks.size()) return;
+        const vector<size_t>& preds = cfg.blocks[to].preds;
+        size_t slot = find(preds.begin(), preds.end(), from) - preds.begin();
+        if (slot == preds.size() || executableEdges[to][slot]) return;
+        executableEdges[to][slot] = true;
+        if (!executable[to]) {
+            executable[to] = true;
+            blockWork.push_back(to);
+        } else {
+            for (size_t phi : ssa.phis[to]) lower(phi, evaluatePhi(phi));
+        }
+    }
+
+    size_t jumpTarget(const string& label, size_t block) const {
+        auto it = cfg.blockByLabel.find(label);
+        return it == cfg.blockByLabel.end() ? block + 1 : it->second;
+    }
+
+    // Edges out of `block` that its last statement can take with what is known so far
+    void visitExit(size_t block) {
+        const TACBlock& b = cfg.blocks[block];
+        const TACInstr* last = b.end > b.begin && !(*body)[b.end - 1].removed ? &(*body)[b.end - 1] : nullptr;
+        if (last && last->kind == TACInstr::IF_GOTO) {
+            Cell l = operandCell(b.end - 1, 0), r = operandCell(b.end - 1, 1);
+            if (l.state == UNDEFINED || r.state == UNDEFINED) return;
+            bool taken;
+            if (l.state == CONSTANT && r.state == CONSTANT && foldCondition(*last, l.value, r.value, taken)) {
+                markEdge(block, taken ? jumpTarget(last->label, block) : block + 1);
+                return;
+            }
+        } else if (last && last->kind == TACInstr::SWITCH) {
+            Cell value = operandCell(b.end - 1, 0);
+            if (value.state == UNDEFINED) return;
+            string target;
+            if (value.state == CONSTANT && foldSwitch(*last, value.value, target)) {
+                markEdge(block, jumpTarget(target, block));
+                return;
+            }
+        }
+        for (size_t succ : b.succs) markEdge(block, succ);
+    }
+
+    void visitStatement(size_t statement) {
+        if (ssa.defOf[statement] != SIZE_MAX) lower(ssa.defOf[statement], evaluateDef(statement));
+        size_t block = cfg.blockOf[statement];
+        if (statement + 1 == cfg.blocks[block].end) visitExit(block);
+    }
+
+    void propagateConstants() {
+        size_t valueCount = ssa.values.size();
+        cells.assign(valueCount, Cell());
+        for (size_t v = 0; v < valueCount; v++) {
+            if (ssa.values[v].kind == TACSSAValue::ENTRY) cells[v].state = VARYING;
+        }
+
+        // Counted first, then placed, so every value's readers are one range
+        firstReader.assign(valueCount + 1, 0);
+        for (const TACSSAValue& value : ssa.values) {
+            for (size_t operand : value.operands) firstReader[operand + 1]++;
+        }
+        for (size_t value : ssa.uses) {
+            if (value != SIZE_MAX) firstReader[value + 1]++;
+        }
+        for (size_t v = 0; v < valueCount; v++) firstReader[v + 1] += firstReader[v];
+        readers.resize(firstReader.back());
+        vector<size_t> next(firstReader.begin(), firstReader.end() - 1);
+        for (size_t v = 0; v < valueCount; v++) {
+            for (size_t operand : ssa.values[v].operands) readers[next[operand]++] = {true, v};
+        }
+        for (size_t i = 0; i < body->size(); i++) {
+            for (size_t use = ssa.firstUse[i]; use < ssa.firstUse[i + 1]; use++) {
+                if (ssa.uses[use] != SIZE_MAX) readers[next[ssa.uses[use]]++] = {false, i};
+            }
+        }
+        executable.assign(cfg.blocks.size(), false);
+        executableEdges.resize(cfg.blocks.size());
+        for (size_t b = 0; b < cfg.blocks.size(); b++) executableEdges[b].assign(cfg.blocks[b].preds.size(), false);
+
+        executable[0] = true;
+        blockWork = {0};
+        while (!blockWork.empty() || !valueWork.empty()) {
+            while (!blockWork.empty()) {
+                size_t block = blockWork.back();
+                blockWork.pop_back();
+                for (size_t phi : ssa.phis[block]) lower(phi, evaluatePhi(phi));
+                for (size_t i = cfg.blocks[block].begin; i < cfg.blocks[block].end; i++) visitStatement(i);
+                if (cfg.blocks[block].end == cfg.blocks[block].begin) visitExit(block);
+            }
+            while (!valueWork.empty()) {
+                size_t value = valueWork.back();
+                valueWork.pop_back();
+                for (size_t r = firstReader[value]; r < firstReader[value + 1]; r++) {
+                    const Reader& reader = readers[r];
+                    if (reader.phi && executable[ssa.values[reader.index].at]) {
+                        lower(reader.index, evaluatePhi(reader.index));
+                    } else if (!reader.phi && executable[cfg.blockOf[reader.index]]) {
+                        visitStatement(reader.index);
+                    }
+                }
+            }
+        }
+    }
+
+    // Constant operands are written in, and jumps they decide folded
+    bool applyConstants() {
+        bool changed = false;
+        for (size_t b = 0; b < cfg.blocks.size(); b++) {
+            if (!executable[b]) continue;
+            for (size_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+                TACInstr& instr = (*body)[i];
+                if (instr.removed) continue;
+                for (size_t k = 0; k < instr.args.size(); k++) {
+                    size_t value = ssa.useOf(i, k);
+                    if (value == SIZE_MAX || cells[value].state != CONSTANT) continue;
+                    instr.args[k] = formatConstant(cells[value].value);
+                    instr.changed = true;
+                    ssa.useOf(i, k) = SIZE_MAX;
+                    stats.propagated++;
+                    changed = true;
+                }
+                if (foldJump(instr)) {
+                    stats.folded++;
+                    changed = true;
+                }
+            }
+        }
+        return changed;
+    }
+
+    // Operand identity for value numbering: the SSA value, or the text of anything else
+    string operandKey(size_t statement, size_t use) const {
+        size_t value = ssa.useOf(statement, use);
+        return value == SIZE_MAX ? (*body)[statement].args[use] : "%" + to_string(value);
+    }
+
+    static bool isCommutative(const string& op) {
+        return op == "+" || op == "*" || op == "==" || op == "!=" || op == "&" || op == "|" || op == "^" ||
+               op == "&&" || op == "||";
+    }
+
+    bool numberValues() {
+        leaders.clear();
+        vector<vector<size_t>> children(cfg.blocks.size());
+        for (size_t b : cfg.order) {
+            if (b != 0) children[cfg.blocks[b].idom].push_back(b);
+        }
+
+        bool changed = false;
+        vector<pair<size_t, size_t>> walk = {{0, 0}};   // block, size of `added` when it was entered
+        vector<string> added;
+        vector<bool> visited(cfg.blocks.size(), false);
+        while (!walk.empty()) {
+            auto [block, mark] = walk.back();
+            if (visited[block]) {
+                walk.pop_back();
+                for (; added.size() > mark; added.pop_back()) leaders.erase(added.back());
+                continue;
+            }
+            visited[block] = true;
+            for (size_t i = cfg.blocks[block].begin; i < cfg.blocks[block].end; i++) {
+                TACInstr& instr = (*body)[i];
+                if (instr.removed || instr.kind != TACInstr::ASSIGN || instr.op.empty() || instr.op == "call") continue;
+                bool plain = true;
+                for (size_t k = 0; k < instr.args.size(); k++) {
+                    VarType type = types->typeOf(instr.args[k]);
+                    if (isReassignedTemp(ssa.useOf(i, k)) || type == VarType::STRING || type == VarType::UNKNOWN) {
+                        plain = false;
+                    }
+                }
+                if (!plain) continue;
+
+                string left = operandKey(i, 0);
+                string right = instr.args.size() == 2 ? operandKey(i, 1) : string();
+                if (!right.empty() && isCommutative(instr.op) && right < left) swap(left, right);
+                string key = instr.op + " " + left + " " + right;
+
+                auto it = leaders.find(key);
+                if (it != leaders.end() && it->second.statement < i) {
+                    instr.op.clear();
+                    instr.args = {it->second.name};
+                    instr.changed = true;
+                    ssa.useOf(i, 0) = it->second.value;
+                    if (!right.empty()) ssa.useOf(i, 1) = SIZE_MAX;
+                    stats.redundant++;
+                    changed = true;
+                } else if (it == leaders.end() && isTempName(instr.dest) && instr.type.empty() &&
+                           !isReassignedTemp(ssa.defOf[i])) {
+                    leaders.emplace(key, Leader{instr.dest, ssa.defOf[i], i});
+                    added.push_back(std::move(key));
+                }
+            }
+            for (auto child = children[block].rbegin(); child != children[block].rend(); ++child) {
+                walk.push_back({*child, added.size()});
+            }
+        }
+        return changed;
+    }
+
+    bool removeDeadCode() {
+        vector<bool> liveValue(ssa.values.size(), false);
+        vector<bool> liveStatement(body->size(), false);
+        vector<size_t> worklist;
+        auto markUses = [&](size_t statement) {
+            if (liveStatement[statement]) return;
+            liveStatement[statement] = true;
+            for (size_t use = ssa.firstUse[statement]; use < ssa.firstUse[statement + 1]; use++) {
+                size_t value = ssa.uses[use];
+                if (value != SIZE_MAX && !liveValue[value]) {
+                    liveValue[value] = true;
+                    worklist.push_back(value);
+                }
+            }
+        };
+
+        // A name's declarations fix its type and slot, so they stay while any of its values is used
+        vector<vector<size_t>> declarations(ssa.variables.size());
+        for (size_t b : cfg.order) {
+            for (size_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+                const TACInstr& instr = (*body)[i];
+                if (instr.removed || instr.kind == TACInstr::LABEL || instr.kind == TACInstr::OTHER) continue;
+                if (instr.kind != TACInstr::ASSIGN || instr.op == "call") markUses(i);
+                if (ssa.defOf[i] != SIZE_MAX && (!instr.type.empty() || isReassignedTemp(ssa.defOf[i]))) {
+                    declarations[ssa.values[ssa.defOf[i]].variable].push_back(i);
+                }
+            }
+        }
+        vector<bool> liveVariable(ssa.variables.size(), false);
+        while (!worklist.empty()) {
+            const TACSSAValue& value = ssa.values[worklist.back()];
+            worklist.pop_back();
+            if (value.kind == TACSSAValue::DEF) markUses(value.at);
+            for (size_t operand : value.operands) {
+                if (!liveValue[operand]) {
+                    liveValue[operand] = true;
+                    worklist.push_back(operand);
+                }
+            }
+            if (!liveVariable[value.variable]) {
+                liveVariable[value.variable] = true;
+                for (size_t statement : declarations[value.variable]) markUses(statement);
+            }
+        }
+
+        bool changed = false;
+        for (size_t b : cfg.order) {
+            for (size_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+                TACInstr& instr = (*body)[i];
+                if (instr.removed || instr.kind != TACInstr::ASSIGN) continue;
+                size_t def = ssa.defOf[i];
+                if (instr.op == "call") {
+                    bool declaration = !instr.type.empty() || isReassignedTemp(def);
+                    if (liveValue[def] || (declaration && liveVariable[ssa.values[def].variable])) continue;
+                    // Still a call, now without a result
+                    instr.kind = TACInstr::CALL;
+                    instr.type.clear();
+                    instr.dest.clear();
+                    instr.op.clear();
+                    instr.changed = true;
+                } else if (!liveStatement[i]) {
+                    instr.removed = true;
+                } else {
+                    continue;
+                }
+                stats.removed++;
+                changed = true;
+            }
+        }
+        return changed;
+    }
+
+public:
+    explicit SSAOptimizer(OptimizerStats& optimizerStats) : stats(optimizerStats) {}
+
+    // Runs after FunctionOptimizer, whose operand types it uses; true if the body changed
+    bool run(vector<TACInstr>& instrs, const FunctionOptimizer& optimizer) {
+        body = &instrs;
+        types = &optimizer;
+        instrs.erase(remove_if(instrs.begin(), instrs.end(), [](const TACInstr& instr) { return instr.removed; }),
+                     instrs.end());
+        build();
+        propagateConstants();
+        bool changed = applyConstants();
+        changed |= numberValues();
+        changed |= removeDeadCode();
+        return changed;
+    }
+};
+
+// === Loop Optimizer ===
+// Natural loops come from the control flow graph: an edge to a block that dominates its source
+// closes a loop. A loop qualifies when its header is a label entered from outside only by
+// falling in from the block before it, so code placed right before the header (the
+// preheader) runs once before the first iteration. Inner loops are handled first; what they
+// hoist lands in the enclosing loop and can move further out.
+//
+// - loop-invariant code motion: temporaries computed only from constants, names the loop never
+//   assigns and other hoisted temporaries move to the preheader
+// - strength reduction: for an int induction variable v (its only assignment in the loop adds
+//   a constant) and a loop-invariant int k, v * k becomes a new local `$iv<N>` that starts at
+//   v * k and grows by k * step right after each update of v
+// - increments: `t = v + c` / `v = t` with t read nowhere else becomes `v = v + c`
+//
+// All loops of a function are found on one control flow graph. Transformations only record
+// where statements move and what is inserted, and the body is rebuilt once at the end, so a
+// pass costs the function plus the sizes of its loops rather than the function once per loop.
+
+class LoopOptimizer {
+private:
+    struct Loop {
+        size_t header;              // index of the header label
+        vector<size_t> statements;  // indices of the loop's statements, in order
+    };
+
+    // Insertions in front of one header, in order
+    struct Preheader {
+        vector<size_t> hoisted;     // statements moved here, unless an enclosing loop moved them on
+        vector<TACInstr> created;   // initial values of strength-reduced variables
+    };
+
+    vector<TACInstr>* body = nullptr;
+    const FunctionOptimizer* types = nullptr;
+    OptimizerStats& stats;
+    int nextVariable = 0;
+
+    TACControlFlowGraph cfg;
+    unordered_map<string, int> assignments;   // whole function, per destination
+    unordered_map<string, int> reads;         // whole function, per operand
+    unordered_set<string> declared;
+    unordered_set<string> assigned;           // destinations inside the current loop
+    unordered_set<string> hoisted;            // temporaries the current loop moved out
+    unordered_set<string> reducedVariables;   // `$iv<N>` names of the current function
+
+    // Edits of the current pass, applied by rebuild()
+    vector<size_t> hoistedTo;                          // per statement: header it moves in front of
+    unordered_map<size_t, Preheader> preheaders;       // by header index
+    unordered_map<size_t, vector<TACInstr>> updates;   // by statement index: inserted right after it
+
+    void indexFunction() {
+        cfg = buildFlowGraph(*body);
+        assignments.clear();
+        reads.clear();
+        declared.clear();
+        for (const TACInstr& instr : *body) {
+            for (const string& arg : instr.args) reads[arg]++;
+            if (instr.kind != TACInstr::ASSIGN) continue;
+            assignments[instr.dest]++;
+            if (!instr.type.empty()) declared.insert(instr.dest);
+        }
+    }
+
+    // Header blocks of all natural loops, innermost (smallest) loops first
+    vector<size_t> findHeaders() const {
+        unordered_map<size_t, size_t> sizes;
+        for (size_t tail : cfg.order) {
+            for (size_t header : cfg.blocks[tail].succs) {
+                if (cfg.dominates(header, tail)) sizes[header] = max(sizes[header], cfg.naturalLoop(header, tail).size());
+            }
+        }
+        vector<pair<size_t, size_t>> loops(sizes.begin(), sizes.end());
+        sort(loops.begin(), loops.end(), [](const auto& a, const auto& b) {
+            return a.second != b.second ? a.second < b.second : a.first < b.first;
+        });
+        vector<size_t> headers;
+        for (const auto& [header, size] : loops) {
+            if ((*body)[cfg.blocks[header].begin].kind == TACInstr::LABEL) headers.push_back(header);
+        }
+        return headers;
+    }
+
+    // The loop headed by `block`, if control can only enter it through the preheader
+    bool locate(size_t block, Loop& loop) const {
+        if (block == 0 || !cfg.blocks[block].reachable) return false;
+        const string& header = (*body)[cfg.blocks[block].begin].label;
+
+        // Member blocks in statement order; the loop's size bounds the work, not the function's
+        vector<size_t> members;
+        for (size_t tail : cfg.blocks[block].preds) {
+            if (!cfg.dominates(block, tail)) continue;
+            vector<size_t> blocks = cfg.naturalLoop(block, tail);
+            members.insert(members.end(), blocks.begin(), blocks.end());
+        }
+        if (members.empty()) return false;
+        sort(members.begin(), members.end());
+        members.erase(unique(members.begin(), members.end()), members.end());
+        for (size_t pred : cfg.blocks[block].preds) {
+            if (pred != block - 1 && !binary_search(members.begin(), members.end(), pred)) return false;
+        }
+        // The block before falls in rather than jumping
+        const TACBlock& before = cfg.blocks[block - 1];
+        if (before.end > before.begin) {
+            const TACInstr& last = (*body)[before.end - 1];
+            if (last.kind == TACInstr::GOTO || last.kind == TACInstr::RETURN || last.kind == TACInstr::SWITCH ||
+                (last.kind == TACInstr::IF_GOTO && last.label == header)) return false;
+        }
+
+        loop.header = cfg.blocks[block].begin;
+        loop.statements.clear();
+        for (size_t b : members) {
+            for (size_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) loop.statements.push_back(i);
+        }
+        return true;
+    }
+
+    // Statements an inner loop hoisted still belong to this one: they sit in its body
+    void collectAssigned(const Loop& loop) {
+        assigned.clear();
+        for (size_t i : loop.statements) {
+            const TACInstr& instr = (*body)[i];
+            if (!instr.removed && instr.kind == TACInstr::ASSIGN) assigned.insert(instr.dest);
+        }
+    }
+
+    bool isInvariant(const string& operand) const {
+        if (reducedVariables.count(operand)) return false;
+        return !assigned.count(operand) || hoisted.count(operand);
+    }
+
+    // Pure, cannot trap, and writes a temporary assigned nowhere else
+    bool isHoistable(const TACInstr& instr) const {
+        if (instr.removed || instr.kind != TACInstr::ASSIGN || !instr.type.empty() || instr.op == "call") return false;
+        if (!isTempName(instr.dest) || assignments.at(instr.dest) != 1 || declared.count(instr.dest)) return false;
+        for (const string& arg : instr.args) {
+            if (!isInvariant(arg)) return false;
+        }
+        if (instr.op == "/" || instr.op == "%") {
+            // Integer division traps on zero and INT_MIN / -1, so it only moves with a safe divisor
+            auto floating = [](VarType type) { return type == VarType::FLOAT || type == VarType::DOUBLE; };
+            if (floating(types->typeOf(instr.args[0])) || floating(types->typeOf(instr.args[1]))) return true;
+            Constant divisor;
+            return parseConstant(instr.args[1], divisor) && divisor.type == VarType::INT &&
+                   divisor.i != 0 && divisor.i != -1;
+        }
+        return true;
+    }
+
+    // Indentation for statements placed in front of the header
+    string preheaderIndent(const Loop& loop) const {
+        for (size_t i = loop.header; i-- > 0;) {
+            const TACInstr& instr = (*body)[i];
+            if (instr.kind == TACInstr::LABEL || (instr.kind == TACInstr::OTHER && instr.indent.empty())) continue;
+            return instr.indent;
+        }
+        return "  ";
+    }
+
+    bool hoistInvariants(const Loop& loop) {
+        vector<TACInstr>& instrs = *body;
+        collectAssigned(loop);
+        hoisted.clear();
+        string indent;
+        for (size_t i : loop.statements) {
+            if (!isHoistable(instrs[i])) continue;
+            if (hoisted.empty()) indent = preheaderIndent(loop);
+            TACInstr& instr = instrs[i];
+            hoisted.insert(instr.dest);
+            hoistedTo[i] = loop.header;
+            preheaders[loop.header].hoisted.push_back(i);
+            instr.indent = indent;
+            instr.changed = true;
+            stats.hoisted++;
+        }
+        return !hoisted.empty();
+    }
+
+    // Step of a basic induction variable updated by `instr` (`v = v + c`, `v = c + v`, `v = v - c`)
+    static bool constantStep(const TACInstr& instr, const string& var, int32_t& step) {
+        if (instr.kind != TACInstr::ASSIGN || instr.args.size() != 2) return false;
+        Constant c;
+        if (instr.op == "+" && instr.args[0] == var && parseConstant(instr.args[1], c)) step = c.i;
+        else if (instr.op == "+" && instr.args[1] == var && parseConstant(instr.args[0], c)) step = c.i;
+        else if (instr.op == "-" && instr.args[0] == var && parseConstant(instr.args[1], c)) step = -static_cast<uint32_t>(c.i);
+        else return false;
+        return c.type == VarType::INT;
+    }
+
+    TACInstr makeAssign(const string& indent, const string& type, const string& dest, const string& op,
+                        vector<string> args) const {
+        TACInstr instr;
+        instr.kind = TACInstr::ASSIGN;
+        instr.indent = indent;
+        instr.type = type;
+        instr.dest = dest;
+        instr.op = op;
+        instr.args = std::move(args);
+        instr.changed = true;
+        return instr;
+    }
+
+    // Runs right after hoistInvariants on the same loop, whose `assigned` and `hoisted` it uses
+    bool reduceStrength(const Loop& loop) {
+        vector<TACInstr>& instrs = *body;
+
+        // Basic induction variables: the index of their single update and its step
+        unordered_map<string, pair<size_t, int32_t>> inductions;
+        unordered_map<string, size_t> definitions;
+        unordered_map<string, int> updateCounts;
+        for (size_t i : loop.statements) {
+            const TACInstr& instr = instrs[i];
+            if (instr.removed || instr.kind != TACInstr::ASSIGN) continue;
+            updateCounts[instr.dest]++;
+            if (isTempName(instr.dest)) definitions[instr.dest] = i;
+        }
+        bool changed = false;
+        for (size_t i : loop.statements) {
+            TACInstr& instr = instrs[i];
+            if (instr.removed || instr.kind != TACInstr::ASSIGN || !instr.type.empty() || isTempName(instr.dest)) continue;
+            const string& var = instr.dest;
+            if (updateCounts[var] != 1 || types->typeOf(var) != VarType::INT) continue;
+            int32_t step;
+            if (constantStep(instr, var, step)) {
+                inductions[var] = {i, step};
+                continue;
+            }
+            if (!instr.op.empty() || !isTempName(instr.args[0])) continue;
+            auto def = definitions.find(instr.args[0]);
+            if (def == definitions.end() || def->second > i || !constantStep(instrs[def->second], var, step)) continue;
+            inductions[var] = {i, step};
+            if (reads[instr.args[0]] == 1 && assignments[instr.args[0]] == 1) {
+                // The temporary only carried the new value: update in place
+                TACInstr& increment = instrs[def->second];
+                instr.op = increment.op;
+                instr.args = increment.args;
+                instr.changed = true;
+                increment.removed = true;
+                changed = true;
+            }
+        }
+        if (inductions.empty()) return changed;
+
+        // v * k with k invariant: one variable per (v, k), updates to insert after each v update
+        map<pair<string, string>, string> reduced;
+        string indent;
+        for (size_t i : loop.statements) {
+            TACInstr& instr = instrs[i];
+            if (instr.removed || instr.kind != TACInstr::ASSIGN || instr.op != "*") continue;
+            for (int side = 0; side < 2; side++) {
+                const string& var = instr.args[side];
+                const string& factor = instr.args[1 - side];
+                auto induction = inductions.find(var);
+                if (induction == inductions.end() || induction->second.first == i) continue;
+                if (!isInvariant(factor) || types->typeOf(factor) != VarType::INT) continue;
+
+                int32_t step = induction->second.second;
+                Constant k;
+                string increment;
+                string op = "+";
+                if (parseConstant(factor, k)) {
+                    increment = to_string(static_cast<int32_t>(static_cast<uint32_t>(k.i) * static_cast<uint32_t>(step)));
+                } else if (step == 1 || step == -1) {
+                    increment = factor;
+                    if (step == -1) op = "-";
+                } else {
+                    continue;
+                }
+
+                auto key = make_pair(var, factor);
+                auto it = reduced.find(key);
+                if (it == reduced.end()) {
+                    string name = "$iv" + to_string(nextVariable++);
+                    it = reduced.emplace(key, name).first;
+                    reducedVariables.insert(name);
+                    if (indent.empty()) indent = preheaderIndent(loop);
+                    preheaders[loop.header].created.push_back(makeAssign(indent, "int", name, "*", {var, factor}));
+                    const TACInstr& update = instrs[induction->second.first];
+                    updates[induction->second.first].push_back(makeAssign(update.indent, "", name, op, {name, increment}));
+                }
+                instr.op.clear();
+                instr.args = {it->second};
+                instr.changed = true;
+                stats.reduced++;
+                changed = true;
+                break;
+            }
+        }
+        return changed;
+    }
+
+    // Applies the pass's edits in one sweep over the body
+    void rebuild() {
+        vector<TACInstr>& instrs = *body;
+        size_t created = 0;
+        for (const auto& [header, preheader] : preheaders) created += preheader.created.size();
+        for (const auto& [statement, inserted] : updates) created += inserted.size();
+
+        vector<TACInstr> result;
+        result.reserve(instrs.size() + created);
+        for (size_t i = 0; i < instrs.size(); i++) {
+            auto preheader = preheaders.find(i);
+            if (preheader != preheaders.end()) {
+                for (size_t moved : preheader->second.hoisted) {
+                    if (hoistedTo[moved] == i) result.push_back(std::move(instrs[moved]));
+                }
+                for (TACInstr& instr : preheader->second.created) result.push_back(std::move(instr));
+            }
+            if (hoistedTo[i] == SIZE_MAX && !instrs[i].removed) result.push_back(std::move(instrs[i]));
+            auto inserted = updates.find(i);
+            if (inserted != updates.end()) {
+                for (TACInstr& instr : inserted->second) result.push_back(std::move(instr));
+            }
+        }
+        instrs = std::move(result);
+    }
+
+public:
+    explicit LoopOptimizer(OptimizerStats& optimizerStats) : stats(optimizerStats) {}
+
+    // Runs after FunctionOptimizer, whose operand types it uses; true if the body changed
+    bool run(vector<TACInstr>& instrs, const FunctionOptimizer& optimizer) {
+        body = &instrs;
+        types = &optimizer;
+        instrs.erase(remove_if(instrs.begin(), instrs.end(), [](const TACInstr& instr) { return instr.removed; }),
+                     instrs.end());
+        indexFunction();
+        hoistedTo.assign(instrs.size(), SIZE_MAX);
+        preheaders.clear();
+        updates.clear();
+        reducedVariables.clear();
+
+        bool changed = false;
+        for (size_t header : findHeaders()) {
+            Loop loop;
+            if (!locate(header, loop)) continue;
+            changed |= hoistInvariants(loop);
+            changed |= reduceStrength(loop);
+        }
+        // The graph's label keys point into the statements about to move
+        cfg = TACControlFlowGraph();
+        if (changed) rebuild();
+        return changed;
+    }
+};
+
+bool isFunctionBegin(const string& line) {
+    return line.find("function ") != string::npos && line.find(" begin") != string::npos;
+}
+
+bool isFunctionEnd(const string& line) {
+    return line.find("function ") != string::npos && line.find(" end") != string::npos;
+}
+
+string functionName(const string& line) {
+    size_t start = line.find("function ") + 9;
+    return line.substr(start, line.find(' ', start) - start);
+}
+
+// === Program ===
+
+// One `function name begin` ... `function name end` block and the lines in front of it
+struct TACFunction {
+    string name;
+    vector<string> leading;        // comments and other lines before the begin line
+    string begin;
+    string end;                    // empty if the text ended inside the function
+    string returnTypeName;         // as written before `function`, "int" if nothing is
+    VarType returnType = VarType::INT;
+    vector<pair<string, VarType>> params;
+    vector<string> paramTypeNames;
+    vector<TACInstr> body;         // including the `type name = param` lines, as OTHER
+    bool understood = true;        // every line parsed, so the passes may rewrite it
+};
+
+struct TACProgram {
+    vector<TACFunction> functions;
+    vector<string> trailing;       // lines after the last function
+};
+
+TACProgram parseProgram(const string& tac) {
+    TACProgram program;
+    vector<string> pending;
+    istringstream in(tac);
+    string line;
+    while (getline(in, line)) {
+        if (!isFunctionBegin(line)) {
+            pending.push_back(std::move(line));
+            continue;
+        }
+
+        program.functions.emplace_back();
+        TACFunction& function = program.functions.back();
+        function.name = functionName(line);
+        function.leading = std::move(pending);
+        pending.clear();
+        string_view type = trim(string_view(line).substr(0, line.find("function ")));
+        // Return types, as TACExecutor::firstPass assigns them (no type means int)
+        function.returnTypeName = type.empty() ? "int" : string(type);
+        function.returnType = parseTypeName(function.returnTypeName);
+        function.begin = std::move(line);
+
+        while (getline(in, line) && !isFunctionEnd(line)) {
+            function.body.emplace_back();
+            TACInstr& instr = function.body.back();
+            instr.text = std::move(line);
+            parseInstr(instr);
+
+            string_view stmt = trim(instr.text);
+            if (instr.kind == TACInstr::OTHER && !stmt.empty() && !startsWith(stmt, "//")) {
+                // `type name = param` declares a parameter; any other unknown line disables the passes
+                size_t space = stmt.find(' ');
+                size_t eqPos = stmt.find(" = param");
+                if (space != string_view::npos && eqPos != string_view::npos && space < eqPos) {
+                    string typeName(stmt.substr(0, space));
+                    function.params.push_back({string(trim(stmt.substr(space + 1, eqPos - space - 1))),
+                                               parseTypeName(typeName)});
+                    function.paramTypeNames.push_back(std::move(typeName));
+                } else {
+                    function.understood = false;
+                }
+            }
+        }
+        if (isFunctionEnd(line)) function.end = std::move(line);
+    }
+    program.trailing = std::move(pending);
+    return program;
+}
+
+void printLine(const string& line, string& out) {
+    out += line;
+    out += '\n';
+}
+
+void printProgram(const TACProgram& program, string& out) {
+    for (const TACFunction& function : program.functions) {
+        for (const string& line : function.leading) printLine(line, out);
+        printLine(function.begin, out);
+        for (const TACInstr& instr : function.body) {
+            if (instr.removed) continue;
+            printInstr(instr, out);
+            out += '\n';
+        }
+        if (!function.end.empty()) printLine(function.end, out);
+    }
+    for (const string& line : program.trailing) printLine(line, out);
+}
+
+bool isLabelNumber(const string& label) {
+    return label.size() > 1 && label[0] == 'L' && label.find_first_not_of("0123456789", 1) == string::npos;
+}
+
+// Temporaries and labels the passes add, numbered above every one already in the program
+class FreshNames {
+private:
+    int nextTemp = 0;
+    int nextLabel = 0;
+
+public:
+    explicit FreshNames(const vector<TACFunction>& functions) {
+        for (const TACFunction& function : functions) {
+            for (const TACInstr& instr : function.body) {
+                if (instr.kind == TACInstr::LABEL && isLabelNumber(instr.label)) {
+                    nextLabel = max(nextLabel, atoi(instr.label.c_str() + 1) + 1);
+                }
+                if (instr.kind == TACInstr::ASSIGN && isTempName(instr.dest)) {
+                    nextTemp = max(nextTemp, atoi(instr.dest.c_str() + 1) + 1);
+                }
+            }
+        }
+    }
+
+    string temp() { return "t" + to_string(nextTemp++); }
+    string label() { return "L" + to_string(nextLabel++); }
+};
+
+bool isCallSite(const TACInstr& instr) {
+    return (instr.kind == TACInstr::CALL || (instr.kind == TACInstr::ASSIGN && instr.op == "call")) &&
+           instr.callee != "print";
+}
+
+// === Inliner ===
+// Replaces calls to small leaf functions by a copy of their body, so hot helpers cost no call
+// even on the -O0 JIT path. Functions are handled callees first (bottom-up over the call
+// graph), so a helper has already absorbed and optimized its own small callees when its size
+// is judged. Recursion is never unrolled: only finished functions are inlined and a function
+// that still calls anything besides print is not a leaf.
+
+constexpr size_t kInlineMaxStatements = 12;   // callee size, labels and parameters not counted
+constexpr size_t kInlineMaxCallerSize = 2000; // no more inlining into a caller this large
+
+class Inliner {
+private:
+    vector<TACFunction>& functions;
+    FreshNames& fresh;
+    OptimizerStats& stats;
+    unordered_map<string, size_t> indexByName;
+    vector<bool> inlinable;
+    int nextSite = 0;
+
+    // Whether this call can be replaced by the callee's body
+    bool canInline(const TACInstr& call, const TACFunction& callee) const {
+        if (call.args.size() != callee.params.size()) return false;
+        if (call.kind != TACInstr::ASSIGN) return true;
+        // A result that may come from falling off the end or a bare return starts out as 0,
+        // which a string cannot hold
+        return callee.returnType != VarType::STRING || !mayReturnDefault(callee);
+    }
+
+    static bool mayReturnDefault(const TACFunction& callee) {
+        const TACInstr* last = nullptr;
+        for (const TACInstr& instr : callee.body) {
+            if (instr.removed || instr.kind == TACInstr::OTHER) continue;
+            if (instr.kind == TACInstr::RETURN && instr.args.empty()) return true;
+            last = &instr;
+        }
+        return !last || (last->kind != TACInstr::RETURN && last->kind != TACInstr::GOTO &&
+                         last->kind != TACInstr::SWITCH);
+    }
+
+    // Copies the callee's body in place of `call`. Temporaries and labels get fresh numbers,
+    // locals and parameters a `$site` suffix; parameters and returns become declarations so
+    // values are converted exactly as the call would convert them.
+    void inlineCall(const TACInstr& call, const TACFunction& callee, vector<TACInstr>& out) {
+        string suffix = "$" + to_string(++nextSite);
+        unordered_map<string, string> names;
+        unordered_map<string, string> labels;
+        for (const auto& [name, type] : callee.params) names.emplace(name, name + suffix);
+        size_t lastIndex = 0;
+        for (size_t i = 0; i < callee.body.size(); i++) {
+            const TACInstr& instr = callee.body[i];
+            if (instr.removed || instr.kind == TACInstr::OTHER) continue;
+            lastIndex = i;
+            if (instr.kind == TACInstr::ASSIGN && !names.count(instr.dest)) {
+                names[instr.dest] = isTempName(instr.dest) ? fresh.temp() : instr.dest + suffix;
+            } else if (instr.kind == TACInstr::LABEL) {
+                labels[instr.label] = fresh.label();
+            }
+        }
+        auto rename = [](const unordered_map<string, string>& map, const string& name) {
+            auto it = map.find(name);
+            return it == map.end() ? name : it->second;
+        };
+        auto emit = [&](TACInstr instr) {
+            instr.indent = instr.kind == TACInstr::LABEL ? "" : call.indent;
+            instr.text.clear();
+            instr.changed = true;
+            out.push_back(std::move(instr));
+        };
+        auto declare = [&](const string& type, const string& dest, const string& value) {
+            TACInstr decl;
+            decl.kind = TACInstr::ASSIGN;
+            decl.type = type;
+            decl.dest = dest;
+            decl.args = {value};
+            emit(std::move(decl));
+        };
+
+        bool hasResult = call.kind == TACInstr::ASSIGN;
+        string result = callee.name + suffix;
+        string endLabel;
+
+        for (size_t i = 0; i < callee.params.size(); i++) {
+            declare(callee.paramTypeNames[i], names[callee.params[i].first], call.args[i]);
+        }
+        if (hasResult && mayReturnDefault(callee)) declare(callee.returnTypeName, result, "0");
+
+        for (size_t i = 0; i <= lastIndex && i < callee.body.size(); i++) {
+            const TACInstr& source = callee.body[i];
+            if (source.removed || source.kind == TACInstr::OTHER) continue;
+            TACInstr instr = source;
+            for (string& arg : instr.args) arg = rename(names, arg);
+            if (instr.kind == TACInstr::RETURN) {
+                if (hasResult && !instr.args.empty()) declare(callee.returnTypeName, result, instr.args[0]);
+                if (i == lastIndex) continue;
+                if (endLabel.empty()) endLabel = fresh.label();
+                instr = TACInstr();
+                instr.kind = TACInstr::GOTO;
+                instr.label = endLabel;
+            } else {
+                if (instr.kind == TACInstr::ASSIGN) instr.dest = rename(names, instr.dest);
+                if (!instr.label.empty()) instr.label = rename(labels, instr.label);
+                for (auto& entry : instr.cases) entry.second = rename(labels, entry.second);
+            }
+            emit(std::move(instr));
+        }
+
+        if (!endLabel.empty()) {
+            TACInstr label;
+            label.kind = TACInstr::LABEL;
+            label.label = endLabel;
+            emit(std::move(label));
+        }
+        if (hasResult) declare(call.type, call.dest, result);
+        stats.inlined++;
+    }
+
+    void visit(size_t index, vector<int>& state, vector<size_t>& order) const {
+        state[index] = 1;
+        for (const TACInstr& instr : functions[index].body) {
+            if (!isCallSite(instr)) continue;
+            auto it = indexByName.find(instr.callee);
+            if (it != indexByName.end() && state[it->second] == 0) visit(it->second, state, order);
+        }
+        state[index] = 2;
+        order.push_back(index);
+    }
+
+public:
+    Inliner(vector<TACFunction>& programFunctions, FreshNames& freshNames, OptimizerStats& optimizerStats)
+        : functions(programFunctions), fresh(freshNames), stats(optimizerStats),
+          inlinable(programFunctions.size(), false) {
+        for (size_t i = 0; i < functions.size(); i++) indexByName.emplace(functions[i].name, i);
+    }
+
+    // Callees before callers; within a cycle, the function reached first comes last
+    vector<size_t> bottomUpOrder() const {
+        vector<int> state(functions.size(), 0);
+        vector<size_t> order;
+        for (size_t i = 0; i < functions.size(); i++) {
+            if (state[i] == 0) visit(i, state, order);
+        }
+        return order;
+    }
+
+    // Inlines the calls of `caller` whose callee has already been finished and qualifies
+    void run(TACFunction& caller) {
+        bool any = false;
+        for (const TACInstr& instr : caller.body) {
+            if (!isCallSite(instr)) continue;
+            auto it = indexByName.find(instr.callee);
+            if (it != indexByName.end() && inlinable[it->second]) any = true;
+        }
+        if (!any) return;
+
+        vector<TACInstr> body;
+        body.reserve(caller.body.size());
+        for (TACInstr& instr : caller.body) {
+            if (instr.removed) continue;
+            if (isCallSite(instr) && body.size() < kInlineMaxCallerSize) {
+                auto it = indexByName.find(instr.callee);
+                if (it != indexByName.end() && inlinable[it->second] &&
+                    canInline(instr, functions[it->second])) {
+                    inlineCall(instr, functions[it->second], body);
+                    continue;
+                }
+            }
+            body.push_back(std::move(instr));
+        }
+        caller.body = std::move(body);
+    }
+
+    // functions[index] is optimized; from now on calls to it may be inlined if it is small and a leaf
+    void finish(size_t index) {
+        const TACFunction& function = functions[index];
+        if (!function.understood || function.name == "main") return;
+        size_t statements = 0;
+        for (const TACInstr& instr : function.body) {
+            if (instr.removed || instr.kind == TACInstr::OTHER || instr.kind == TACInstr::LABEL) continue;
+            if (isCallSite(instr) || ++statements > kInlineMaxStatements) return;
+        }
+        inlinable[index] = true;
+    }
+};
+
+// === Tail Recursion ===
+// A call of the function itself whose result is returned right away (or, in a void function,
+// that is followed only by a return) becomes a loop: the arguments are stored into the
+// parameters and control jumps back to a label after the `= param` lines. Deep recursion then
+// runs in constant stack on every backend path, including the -O0 JIT where LLVM would not
+// turn the call into a jump.
+
+// The statement after body[index] that runs next, or nullptr at the end of the function
+const TACInstr* nextStatement(const vector<TACInstr>& body, size_t index) {
+    for (size_t i = index + 1; i < body.size(); i++) {
+        if (!body[i].removed && body[i].kind != TACInstr::OTHER) return &body[i];
+    }
+    return nullptr;
+}
+
+bool isTailCall(const TACFunction& function, size_t index) {
+    const TACInstr& call = function.body[index];
+    if (!isCallSite(call) || call.callee != function.name || call.args.size() != function.params.size()) {
+        return false;
+    }
+    const TACInstr* next = nextStatement(function.body, index);
+    if (function.returnType == VarType::VOID) {
+        return !next || (next->kind == TACInstr::RETURN && next->args.empty());
+    }
+    return call.kind == TACInstr::ASSIGN && next && next->kind == TACInstr::RETURN &&
+           next->args.size() == 1 && next->args[0] == call.dest;
+}
+
+void eliminateTailRecursion(TACFunction& function, FreshNames& fresh, OptimizerStats& stats) {
+    if (function.name == "main") return;
+    bool any = false;
+    for (size_t i = 0; i < function.body.size() && !any; i++) any = isTailCall(function, i);
+    if (!any) return;
+
+    string top = fresh.label();
+    vector<TACInstr> body;
+    body.reserve(function.body.size() + 4);
+    bool placedTop = false;
+    for (size_t i = 0; i < function.body.size(); i++) {
+        if (!placedTop && function.body[i].kind != TACInstr::OTHER) {
+            TACInstr label;
+            label.kind = TACInstr::LABEL;
+            label.label = top;
+            label.changed = true;
+            body.push_back(std::move(label));
+            placedTop = true;
+        }
+        if (!isTailCall(function, i)) {
+            body.push_back(std::move(function.body[i]));
+            continue;
+        }
+
+        const TACInstr& call = function.body[i];
+        auto emit = [&](TACInstr instr) {
+            instr.indent = call.indent;
+            instr.changed = true;
+            body.push_back(std::move(instr));
+        };
+        // Parameters are assigned in order, so an argument naming a parameter that an earlier
+        // assignment overwrites is read into a temporary first
+        vector<string> values = call.args;
+        for (size_t k = 0; k < values.size(); k++) {
+            for (size_t m = 0; m < k; m++) {
+                if (values[k] != function.params[m].first || call.args[m] == function.params[m].first) continue;
+                TACInstr copy;
+                copy.kind = TACInstr::ASSIGN;
+                copy.dest = fresh.temp();
+                copy.args = {values[k]};
+                values[k] = copy.dest;
+                emit(std::move(copy));
+                break;
+            }
+        }
+        for (size_t k = 0; k < values.size(); k++) {
+            if (values[k] == function.params[k].first) continue;
+            // A declaration converts like passing the argument would
+            TACInstr assign;
+            assign.kind = TACInstr::ASSIGN;
+            assign.type = function.paramTypeNames[k];
+            assign.dest = function.params[k].first;
+            assign.args = {values[k]};
+            emit(std::move(assign));
+        }
+        TACInstr jump;
+        jump.kind = TACInstr::GOTO;
+        jump.label = top;
+        emit(std::move(jump));
+        stats.tailCalls++;
+    }
+    function.body = std::move(body);
+}
+
+} // namespace
+
+string optimizeTAC(const string& tac) {
+    TACProgram program = parseProgram(tac);
+
+    unordered_map<string, VarType> returnTypes;
+    for (const TACFunction& function : program.functions) returnTypes[function.name] = function.returnType;
+
+    OptimizerStats stats;
+    FunctionOptimizer optimizer(returnTypes, stats);
+    SSAOptimizer global(stats);
+    LoopOptimizer loops(stats);
+    FreshNames fresh(program.functions);
+    Inliner inliner(program.functions, fresh, stats);
+    for (size_t index : inliner.bottomUpOrder()) {
+        TACFunction& function = program.functions[index];
+        TRACE_SCOPE("optimizeTACFunction", function.name);
+        if (function.understood) {
+            inliner.run(function);
+            eliminateTailRecursion(function, fresh, stats);
+            optimizer.run(function.body, function.params);
+            if (global.run(function.body, optimizer)) optimizer.run(function.body, function.params);
+            if (loops.run(function.body, optimizer)) optimizer.run(function.body, function.params);
+        }
+        inliner.finish(index);
+    }
+
+    string out;
+    out.reserve(tac.size());
+    printProgram(program, out);
+
+    if (!compilerOptions.quiet) {
+        cout << "TAC optimization: " << stats.folded << " folded, " << stats.propagated << " propagated, "
+             << stats.removed << " removed, " << stats.inlined << " inlined, "
+             << stats.tailCalls << " tail calls, " << stats.hoisted << " hoisted, " << stats.reduced << " reduced, "
+             << stats.redundant << " redundant"
+             << endl;
+    }
+    return out;
+}
@@ -203,6 +203,7 @@ private:
     }
     
     void checkFunctionDecl(const FunctionDecl& func) {
+        TRACE_SCOPE("checkFunctionDecl", func.name);
 
         currentScope->addSymbol(SymbolInfo(func.returnType, func.name, func.line, func.column, true, false, false, false, func.params));
         
@@ -382,6 +383,14 @@ private:
             checkExpressionNode(stmt.value->node);
             TokenType returnType = inferType(stmt.value->node);
             
+            // main may return an int, which becomes the process exit code
+            if (currentFunctionName == "main") {
+                if (!areTypesStrictlyEqual(T_INT, returnType)) {
+                    addError(ErroneousReturnType, stmt.line, stmt.column, currentFunctionName);
+                }
+                return;
+            }
+            
             // Check if returning a value in a void function
             if (currentFunctionReturnType == T_VOID) {
                 addError(ReturnStmtInVoid, stmt.line, stmt.column, currentFunctionName);
@@ -677,6 +686,7 @@ public:
 };
 
 void performTypeChecking(const vector<ASTPtr>& ast, const vector<Token>& tokens) {
+    PhaseTimer timer("type");
     try {
         TypeChecker checker;
         vector<TypeCheckError> errors = checker.check(ast, tokens);
@@ -689,15 +699,20 @@ void performTypeChecking(const vector<ASTPtr>& ast, const vector<Token>& tokens)
             }
             
             cerr << "Type checking failed with " << errors.size() << " error(s)\n";
-            exit(EXIT_FAILURE);
+            throw CompilationError("type checking failed with " + to_string(errors.size()) + " error(s)");
         }
 
-        cout << "\n=== Type Checking Successful ===\n";
-        cout << "No type errors found.\n";
+        if (!compilerOptions.quiet) {
+            cout << "\n=== Type Checking Successful ===\n";
+            cout << "No type errors found.\n";
+        }
 
     }
+    catch (const CompilationError&) {
+        throw;
+    }
     catch (const exception& e) {
         cerr << "[Type Checking Exception] " << e.what() << "\n";
-        exit(EXIT_FAILURE);
+        throw CompilationError("type checking failed");
     }
 }